@@ -0,0 +1,158 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "wrapping_integers.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//每个benchmark先跑WARMUP轮预热,再跑REPS轮,取最快的一轮作为结果(最不受调度/缺页等噪声影响)
+static constexpr unsigned WARMUP = 2;
+static constexpr unsigned REPS = 7;
+
+//把结果累加到这里,防止编译器把被测代码优化掉
+static size_t sink = 0;
+
+//! \brief Run `body` (which performs `ops` operations on `bytes` bytes) with warmup and repetition,
+//! and print the best repetition as ns/op and GB/s
+static void bench(const string &name, const size_t ops, const size_t bytes, const function<void()> &body) {
+    for (unsigned i = 0; i < WARMUP; ++i) {
+        body();
+    }
+    auto best = nanoseconds::max();
+    for (unsigned i = 0; i < REPS; ++i) {
+        const auto start = steady_clock::now();
+        body();
+        best = min(best, duration_cast<nanoseconds>(steady_clock::now() - start));
+    }
+
+    const double ns = best.count();
+    cout << left << setw(50) << name << right << fixed << setprecision(2) << setw(10) << ns / ops << " ns/op";
+    if (bytes > 0) {
+        cout << setw(10) << bytes / ns << " GB/s";
+    }
+    cout << "\n";
+}
+
+static string random_string(const size_t len, mt19937 &rd) {
+    string ret(len, 0);
+    generate(ret.begin(), ret.end(), [&] { return rd(); });
+    return ret;
+}
+
+//ByteStream: 以chunk为单位 write -> peek -> pop,流的容量固定为64KiB
+static void bench_byte_stream(mt19937 &rd) {
+    constexpr size_t total = 64 * 1024 * 1024;
+    for (const size_t chunk : {16UL, 256UL, 1460UL, 16384UL}) {
+        const string data = random_string(chunk, rd);
+        ByteStream stream{65536};
+        bench("ByteStream write/peek/pop chunk=" + to_string(chunk), total / chunk, total, [&] {
+            for (size_t n = 0; n < total; n += chunk) {
+                stream.write(data);
+                sink += stream.peek_output(chunk).size();
+                stream.pop_output(chunk);
+            }
+        });
+    }
+}
+
+//StreamReassembler: 把同一段数据按不同的顺序切成segment喂进去,每轮都用一个新的reassembler
+static void bench_reassembler(mt19937 &rd) {
+    constexpr size_t total = 1024 * 1024;
+    constexpr size_t seg = 1000;
+    const string data = random_string(total, rd);
+
+    //按顺序,不重叠
+    vector<tuple<size_t, size_t>> in_order;
+    for (size_t off = 0; off < total; off += seg) {
+        in_order.emplace_back(off, min(seg, total - off));
+    }
+
+    //完全倒序,直到最后一个segment到达之前都无法输出
+    vector<tuple<size_t, size_t>> reversed(in_order.rbegin(), in_order.rend());
+
+    //随机起点/长度,互相重叠,最后再按顺序补一遍保证覆盖全部数据
+    vector<tuple<size_t, size_t>> overlap;
+    for (size_t i = 0; i < total / seg; ++i) {
+        const size_t off = rd() % total;
+        overlap.emplace_back(off, min(1 + rd() % (2 * seg), total - off));
+    }
+    overlap.insert(overlap.end(), in_order.begin(), in_order.end());
+
+    //恶意的对端:大量1~4字节的小segment,随机位置,互相重叠/重复,最后再按顺序补一遍
+    vector<tuple<size_t, size_t>> tiny;
+    for (size_t i = 0; i < total / 4; ++i) {
+        const size_t off = rd() % total;
+        tiny.emplace_back(off, min(1 + rd() % 4, total - off));
+    }
+    tiny.insert(tiny.end(), in_order.begin(), in_order.end());
+
+    const vector<tuple<string, const vector<tuple<size_t, size_t>> *>> patterns{{"in-order", &in_order},
+                                                                               {"reversed", &reversed},
+                                                                               {"random-overlap", &overlap},
+                                                                               {"tiny-overlap", &tiny}};
+
+    for (const bool windowed : {false, true}) {
+        for (const auto &[name, segments] : patterns) {
+            const string label = "StreamReassembler" + string(windowed ? "(window) " : " ") + name;
+            double hit_rate = 0;
+            bench(label, segments->size(), total, [&, segments = segments] {
+                StreamReassembler reassembler{total, false, windowed};
+                for (const auto &[off, len] : *segments) {
+                    reassembler.push_substring(data.substr(off, len), off, off + len == total);
+                }
+                if (reassembler.stream_out().buffer_size() != total) {
+                    throw runtime_error(label + ": reassembled " + to_string(reassembler.stream_out().buffer_size()) +
+                                        " of " + to_string(total) + " bytes");
+                }
+                sink += reassembler.stream_out().buffer_size();
+                hit_rate = reassembler.fast_path_hit_rate();
+            });
+            cout << "    (in-order fast path taken by " << setprecision(1) << hit_rate * 100 << "% of pushes)\n";
+        }
+    }
+}
+
+//wrap/unwrap: checkpoint紧跟着一个不断增长的绝对序号,模拟TCPReceiver/TCPSender的用法
+static void bench_wrapping(mt19937 &rd) {
+    constexpr size_t ops = 16 * 1024 * 1024;
+    const WrappingInt32 isn{static_cast<uint32_t>(rd())};
+
+    bench("wrap", ops, 0, [&] {
+        for (uint64_t n = 0; n < ops; ++n) {
+            sink += wrap(n * 1460, isn).raw_value();
+        }
+    });
+
+    bench("unwrap", ops, 0, [&] {
+        for (uint64_t n = 0; n < ops; ++n) {
+            const uint64_t abs = n * 1460;
+            sink += unwrap(isn + static_cast<uint32_t>(abs), isn, abs - min<uint64_t>(abs, 65536));
+        }
+    });
+}
+
+int main() {
+    try {
+        mt19937 rd{0};
+        bench_byte_stream(rd);
+        bench_reassembler(rd);
+        bench_wrapping(rd);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    cerr << "(checksum " << sink << ")\n";
+    return EXIT_SUCCESS;
+}
@@ -1,10 +1,19 @@
+#include "emulated_link.hh"
 #include "tcp_connection.hh"
+#include "tcp_memory.hh"
+#include "tcp_sponge_socket.hh"
 
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <iomanip>
 #include <iostream>
+#include <random>
 #include <string>
+#include <thread>
+#include <utility>
 
 using namespace std;
 using namespace std::chrono;
@@ -28,8 +37,9 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder, const bool delayed_ack = false) {
     TCPConfig config;
+    config.delayed_ack = delayed_ack;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -75,9 +85,9 @@ void main_loop(const bool reorder) {
             string_received.append(y.inbound_stream().read(available_output));
         }
 
-        // time passes
-        x.tick(1000);
-        y.tick(1000);
+        // time passes (much less than the retransmission timeout, since every segment was just delivered)
+        x.tick(1);
+        y.tick(1);
     };
 
     while (not y.inbound_stream().eof()) {
@@ -95,18 +105,248 @@ void main_loop(const bool reorder) {
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    cout << "CPU-limited throughput"
+         << (reorder ? " with reordering  : " : delayed_ack ? " with delayed ACKs: " : "                  : ")
+         << gigabits_per_second << " Gbit/s\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
-int main() {
+//模拟的网络环境
+struct LinkScenario {
+    string name;
+    uint64_t one_way_delay_ms;
+    size_t bytes_per_ms;  //瓶颈带宽
+    size_t queue_limit;   //瓶颈队列的长度(segment个数)
+    double loss;
+};
+
+//在模拟的链路上传输一段数据,统计模拟时间内的有效吞吐量(和CPU的速度无关),以及瓶颈处的排队时延
+void emulated_link_loop(const LinkScenario &link, const TCPConfig &config, const string &name) {
+    constexpr size_t transfer_len = 4 * 1024 * 1024;
+    constexpr uint64_t give_up_ms = 3600 * 1000;
+
+    TCPConnection x{config}, y{config};
+    EmulatedLink forward{link.one_way_delay_ms, link.bytes_per_ms, link.queue_limit};
+    EmulatedLink backward{link.one_way_delay_ms, 0, numeric_limits<size_t>::max()};
+    mt19937 rd{0};
+    size_t received = 0;
+    uint64_t now = 0;
+
+    //和LossyFdAdapter一样先随机丢包,剩下的再经过模拟的链路
+    const auto transmit = [&](TCPConnection &from, EmulatedLink &path, TCPConnection &to, const double loss) {
+        path.advance(now);
+        for (; not from.segments_out().empty(); from.segments_out().pop()) {
+            if (uniform_real_distribution<>{}(rd) >= loss) {
+                path.push(from.segments_out().front());
+            }
+        }
+        while (auto seg = path.pop()) {
+            to.segment_received(seg.value());
+        }
+    };
+
+    Buffer bytes_to_send{string(transfer_len, 'x')};
+    x.connect();
+    y.end_input_stream();
+
+    auto loop = [&] {
+        if (now > give_up_ms) {
+            throw runtime_error(name + ": transfer over the emulated link did not finish");
+        }
+        if (bytes_to_send.size() and x.remaining_outbound_capacity()) {
+            const auto written = x.write(string(bytes_to_send.str().substr(0, x.remaining_outbound_capacity())));
+            bytes_to_send.remove_prefix(written);
+            if (bytes_to_send.size() == 0) {
+                x.end_input_stream();
+            }
+        }
+
+        transmit(x, forward, y, link.loss);
+        transmit(y, backward, x, 0);
+
+        received += y.inbound_stream().read(y.inbound_stream().buffer_size()).size();
+
+        x.tick(1);
+        y.tick(1);
+        ++now;
+    };
+
+    while (not y.inbound_stream().eof()) {
+        loop();
+    }
+    const uint64_t elapsed = now;
+
+    if (received != transfer_len) {
+        throw runtime_error(name + ": received " + to_string(received) + " of " + to_string(transfer_len) + " bytes");
+    }
+
+    const double link_mbps = link.bytes_per_ms * 8.0 / 1000;
+    const double goodput_mbps = transfer_len * 8.0 / 1000 / elapsed;
+    cout << left << setw(52) << link.name << setw(14) << name << right << ": " << setw(6) << goodput_mbps
+         << " Mbit/s (" << setw(6) << goodput_mbps / link_mbps * 100 << "% of the link), " << setw(7)
+         << forward.average_queueing_delay() << " ms queueing delay\n";
+
+    while (x.active() or y.active()) {
+        loop();
+    }
+}
+
+void emulated_links() {
+    constexpr size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+    const vector<LinkScenario> links{
+        {"40 ms RTT, 11.6 Mbit/s, shallow buffer", 20, mss, 32, 0},
+        {"40 ms RTT, 11.6 Mbit/s, shallow buffer, 0.5% loss", 20, mss, 32, 0.005},
+        {"40 ms RTT, 11.6 Mbit/s, shallow buffer, 2% loss", 20, mss, 32, 0.02},
+        {"40 ms RTT, 2.9 Mbit/s, deep buffer", 20, mss / 4, 1000, 0},
+        {"10 ms RTT, 186 Mbit/s", 5, 16 * mss, 256, 0},
+    };
+    const vector<pair<CongestionControl::Algorithm, string>> algorithms{
+        {CongestionControl::Algorithm::NewReno, "NewReno"},
+        {CongestionControl::Algorithm::Cubic, "CUBIC"},
+        {CongestionControl::Algorithm::Bbr, "BBR"}};
+
+    cout << fixed << setprecision(2);
+    for (const auto &link : links) {
+        for (const auto &[algorithm, name] : algorithms) {
+            TCPConfig config;
+            config.congestion_control = algorithm;
+            //和真实的协议栈一样按RTT计算超时时间,否则一次超时(1秒)就能抵消丢包恢复上的所有差别
+            config.adaptive_rto = true;
+            emulated_link_loop(link, config, name);
+            //SACK只在有丢包的时候才有区别
+            if (link.loss > 0) {
+                TCPConfig sack = config;
+                sack.sack = true;
+                emulated_link_loop(link, sack, name + "+SACK");
+            }
+            //带宽时延积超过了默认的窗口时,用窗口扩大选项和更大的缓冲区再跑一次.
+            //窗口大了之后慢启动结束时一次会丢很多段,所以同时打开SACK
+            if (link.bytes_per_ms * 2 * link.one_way_delay_ms > TCPConfig::DEFAULT_CAPACITY) {
+                TCPConfig scaled = config;
+                scaled.window_scaling = true;
+                scaled.sack = true;
+                scaled.recv_capacity = scaled.send_capacity = 4 * 1024 * 1024;
+                emulated_link_loop(link, scaled, name + "+WS");
+                //接收窗口和发送缓冲区都从小开始,分别按照应用读取的速度和拥塞窗口自动扩大
+                TCPConfig tuned = scaled;
+                tuned.recv_autotune = true;
+                tuned.send_autotune = true;
+                emulated_link_loop(link, tuned, name + "+WS+AT");
+            }
+            //BBR总是按照自己的速率发送;其他算法打开pacing之后,窗口不再一下子涌进瓶颈的队列
+            if (algorithm != CongestionControl::Algorithm::Bbr) {
+                TCPConfig paced = config;
+                paced.pacing = true;
+                emulated_link_loop(link, paced, name + "+paced");
+            }
+        }
+    }
+}
+
+//很多空闲的连接一共占用多少缓冲区
+void idle_connections() {
+    constexpr size_t n = 1000;
+    for (const bool autotune : {false, true}) {
+        TCPConfig config;
+        config.recv_autotune = config.send_autotune = autotune;
+        deque<TCPConnection> connections;
+        for (size_t i = 0; i < n; ++i) {
+            connections.emplace_back(config);
+        }
+        cout << "Stream buffers of " << n << " idle connections"
+             << (autotune ? ", auto-sized: " : "            : ") << TCPMemory::allocated() / 1024 / 1024.0
+             << " MiB\n";
+    }
+}
+
+//两个TCPOverUDPSpongeSocket在回环接口上传输一段数据,应用和TCP线程之间的数据走socketpair或者共享的环形缓冲区
+void loopback_sockets(const bool shared_ring) {
+    constexpr size_t transfer_len = 64 * 1024 * 1024;
+    const string data(transfer_len, 'x');
+
+    //回环上的RTT很小;缩短超时时间,否则后关闭的一方要等10倍的超时时间(10秒)才能结束
+    TCPConfig config;
+    config.rt_timeout = 100;
+
+    UDPSocket server_udp;
+    server_udp.bind({"127.0.0.1", 0});
+    const Address server_address = server_udp.local_address();
+    TCPOverUDPSpongeSocket server{TCPOverUDPSocketAdapter(move(server_udp))};
+    TCPOverUDPSpongeSocket client{TCPOverUDPSocketAdapter(UDPSocket{})};
+    if (shared_ring) {
+        server.enable_shared_ring();
+        client.enable_shared_ring();
+    }
+
+    //线程里的异常会直接terminate,先存下来,join之后再抛出
+    exception_ptr server_error;
+    size_t received = 0;
+    auto final_time = high_resolution_clock::now();
+    thread server_thread([&] {
+        try {
+            FdAdapterConfig c_ad;
+            c_ad.source = server_address;
+            server.listen_and_accept(config, c_ad);
+            if (shared_ring) {
+                while (not server.ring_eof()) {
+                    received += server.ring_read().size();
+                }
+                server.ring_end_input();
+            } else {
+                while (not server.eof()) {
+                    received += server.read().size();
+                }
+                server.shutdown(SHUT_WR);
+            }
+            final_time = high_resolution_clock::now();
+            server.wait_until_closed();
+        } catch (...) {
+            server_error = current_exception();
+        }
+    });
+
+    FdAdapterConfig c_ad;
+    c_ad.destination = server_address;
+    client.connect(config, c_ad);
+    const auto first_time = high_resolution_clock::now();
+    if (shared_ring) {
+        client.ring_write(data);
+        client.ring_end_input();
+    } else {
+        client.write(data);
+        client.shutdown(SHUT_WR);
+    }
+    client.wait_until_closed();
+    server_thread.join();
+    if (server_error) {
+        rethrow_exception(server_error);
+    }
+
+    if (received != transfer_len) {
+        throw runtime_error("received " + to_string(received) + " of " + to_string(transfer_len) + " bytes");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    cout << fixed << setprecision(2);
+    cout << "Loopback TCP-over-UDP throughput" << (shared_ring ? " via shared ring: " : " via socketpair  : ")
+         << transfer_len * 8.0 / double(duration) << " Gbit/s\n";
+}
+
+int main(int argc, char *argv[]) {
     try {
         main_loop(false);
         main_loop(true);
+        main_loop(false, true);
+        idle_connections();
+        emulated_links();
+        //需要真的网络套接字和线程,只在指定--sockets时运行
+        if (argc > 1 and strcmp(argv[1], "--sockets") == 0) {
+            loopback_sockets(false);
+            loopback_sockets(true);
+        }
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -24,13 +24,30 @@ static void show_usage(const char *argv0, const char *msg) {
          << "                   In server mode, <host>:<port> is the address to bind.\n\n"
 
          << "   -w <winsz>      Use a window of <winsz> bytes                   " << TCPConfig::MAX_PAYLOAD_SIZE
-         << "\n\n"
-
-         << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
+         << "\n"
+         << "   -W              Negotiate window scaling (RFC 7323), for        (no scaling)\n"
+         << "                   windows over 64 KiB\n"
+         << "   -A              Auto-tune the window up to <winsz>, following   (fixed window)\n"
+         << "                   how fast the application reads\n\n"
+
+         << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n"
+         << "   -r              Adapt the timeout to measured RTTs (RFC 6298)   (fixed timeout)\n"
+         << "   -S              Negotiate selective acknowledgments (RFC 2018)  (no SACK)\n"
+         << "   -T              Negotiate timestamps (RFC 7323)                 (no timestamps)\n"
+         << "   -P <kbit/s>     Pace segments at <kbit/s> (0: at cwnd / SRTT)   (no pacing)\n"
+         << "   -N              Coalesce small writes (Nagle's algorithm)       (send at once)\n"
+         << "   -s              Avoid the silly window syndrome (RFC 1122)      (no SWS avoidance)\n"
+         << "   -d              Delay ACKs of in-order data (RFC 1122)          (ACK every segment)\n\n"
 
          << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
          << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
 
+         << "   -Du <delay>     Delay outgoing segments by <delay> ms           (no delay)\n"
+         << "   -Bu <rate>      Emulate an uplink bottleneck of <rate> kbit/s   (no bottleneck)\n"
+         << "   -Qu <segs>      Bottleneck queue holds <segs> segments          1000\n\n"
+
+         << "   -C <alg>        Congestion control: none, newreno, cubic, bbr   newreno\n\n"
+
          << "   -h              Show this message and quit.\n\n";
 
     if (msg != nullptr) {
@@ -68,6 +85,44 @@ static tuple<TCPConfig, FdAdapterConfig, bool> get_config(int argc, char **argv)
             c_fsm.rt_timeout = strtol(argv[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-r", argv[curr], 3) == 0) {
+            c_fsm.adaptive_rto = true;
+            curr += 1;
+
+        } else if (strncmp("-W", argv[curr], 3) == 0) {
+            c_fsm.window_scaling = true;
+            curr += 1;
+
+        } else if (strncmp("-A", argv[curr], 3) == 0) {
+            c_fsm.recv_autotune = true;
+            curr += 1;
+
+        } else if (strncmp("-S", argv[curr], 3) == 0) {
+            c_fsm.sack = true;
+            curr += 1;
+
+        } else if (strncmp("-T", argv[curr], 3) == 0) {
+            c_fsm.timestamps = true;
+            curr += 1;
+
+        } else if (strncmp("-P", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -P requires one argument.");
+            c_fsm.pacing = true;
+            c_fsm.pacing_rate = strtoull(argv[curr + 1], nullptr, 0) * 1000 / 8;
+            curr += 2;
+
+        } else if (strncmp("-N", argv[curr], 3) == 0) {
+            c_fsm.nagle = true;
+            curr += 1;
+
+        } else if (strncmp("-s", argv[curr], 3) == 0) {
+            c_fsm.sws_avoidance = true;
+            curr += 1;
+
+        } else if (strncmp("-d", argv[curr], 3) == 0) {
+            c_fsm.delayed_ack = true;
+            curr += 1;
+
         } else if (strncmp("-Lu", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -Lu requires one argument.");
             float lossrate = strtof(argv[curr + 1], nullptr);
@@ -84,6 +139,39 @@ static tuple<TCPConfig, FdAdapterConfig, bool> get_config(int argc, char **argv)
                 static_cast<LossRateDnT>(static_cast<float>(numeric_limits<LossRateDnT>::max()) * lossrate);
             curr += 2;
 
+        } else if (strncmp("-Du", argv[curr], 4) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -Du requires one argument.");
+            c_filt.delay_ms_up = strtoul(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-Bu", argv[curr], 4) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -Bu requires one argument.");
+            // kbit/s to bytes per millisecond
+            c_filt.rate_up = max(1UL, strtoul(argv[curr + 1], nullptr, 0) / 8);
+            curr += 2;
+
+        } else if (strncmp("-Qu", argv[curr], 4) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -Qu requires one argument.");
+            c_filt.queue_up = strtoul(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-C", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -C requires one argument.");
+            const string algorithm = argv[curr + 1];
+            if (algorithm == "none") {
+                c_fsm.congestion_control = CongestionControl::Algorithm::None;
+            } else if (algorithm == "newreno") {
+                c_fsm.congestion_control = CongestionControl::Algorithm::NewReno;
+            } else if (algorithm == "cubic") {
+                c_fsm.congestion_control = CongestionControl::Algorithm::Cubic;
+            } else if (algorithm == "bbr") {
+                c_fsm.congestion_control = CongestionControl::Algorithm::Bbr;
+            } else {
+                show_usage(argv[0], ("ERROR: unknown congestion control " + algorithm).c_str());
+                exit(1);
+            }
+            curr += 2;
+
         } else if (strncmp("-h", argv[curr], 3) == 0) {
             show_usage(argv[0], nullptr);
             exit(0);
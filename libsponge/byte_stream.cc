@@ -1,7 +1,13 @@
 #include "byte_stream.hh"
 
+#include "file_descriptor.hh"
+#include "util.hh"
+
 #include <algorithm>
+#include <climits>
+#include <cstring>
 #include <iterator>
+#include <memory>
 #include <stdexcept>
 
 // Dummy implementation of a flow-controlled in-memory byte stream.
@@ -16,31 +22,164 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) : cap(capacity) {}
+ByteStream::ByteStream(const size_t capacity, const bool chunked)
+    : _chunked(chunked), _buf(chunked ? 1 : round_up_pow2(capacity)), _mask(_buf.size() - 1), cap(capacity) {}
+
+void ByteStream::copy_in(const char *data, const size_t len) {
+    //写入位置到缓冲区末尾的这一段先写,剩下的绕回缓冲区开头
+    const size_t pos = nwrite & _mask;
+    const size_t first = min(len, _buf.size() - pos);
+    memcpy(_buf.data() + pos, data, first);
+    memcpy(_buf.data(), data + first, len - first);
+}
+
+void ByteStream::copy_out(string &out, const size_t len) const {
+    if (_chunked) {
+        size_t left = len;
+        for (const auto &chunk : _chunks.buffers()) {
+            if (!left) {
+                break;
+            }
+            const size_t n = min(left, chunk.size());
+            out.append(chunk.str().data(), n);
+            left -= n;
+        }
+        return;
+    }
+    const size_t pos = nread & _mask;
+    const size_t first = min(len, _buf.size() - pos);
+    out.append(_buf.data() + pos, first);
+    out.append(_buf.data(), len - first);
+}
+
+size_t ByteStream::write(const string &data) { return write(data.data(), data.length()); }
+
+size_t ByteStream::write(const char *data, const size_t len) {
+    const size_t ret = min(len, remaining_capacity());
+    if (_chunked) {
+        if (ret) {
+            _chunks.append(Buffer(string(data, ret)));
+        }
+    } else {
+        copy_in(data, ret);
+    }
+    this->nwrite += ret;
+    return ret;
+}
+
+size_t ByteStream::write(Buffer data) {
+    const size_t ret = min(data.size(), remaining_capacity());
+    if (_chunked) {
+        if (ret) {
+            //只保留能放下的前缀,不拷贝数据
+            data.remove_suffix(data.size() - ret);
+            _chunks.append(move(data));
+        }
+    } else {
+        copy_in(data.str().data(), ret);
+    }
+    this->nwrite += ret;
+    return ret;
+}
 
-size_t ByteStream::write(const string &data) {
-    size_t ret = data.length()+this->buf.size()>this->cap ? this->cap-this->buf.size() : data.length();
-    for (size_t i = 0; i < ret; i++)
-        this->buf.push_back(data[i]);
+size_t ByteStream::read_from(FileDescriptor &fd, const size_t limit) {
+    const size_t len = min(limit, remaining_capacity());
+    if (_chunked) {
+        //chunked模式下没有环形缓冲区,readv到一块新分配的(不清零的)内存里,直接作为一个新的chunk
+        const size_t size = min(len, MAX_READ_CHUNK);
+        shared_ptr<char> storage(new char[size], default_delete<char[]>());
+        const size_t ret = fd.read({{storage.get(), size}});
+        //容量很大而这次读到的很少时,不要让这个chunk一直占着整块内存,拷贝出读到的部分
+        if (2 * ret < size) {
+            return write(Buffer(string(storage.get(), ret)));
+        }
+        Buffer data(move(storage), size);
+        data.remove_suffix(size - ret);
+        return write(move(data));
+    }
+    //空闲的空间从写指针开始,最多分成到缓冲区末尾,以及缓冲区开头两段
+    const size_t pos = nwrite & _mask;
+    const size_t first = min(len, _buf.size() - pos);
+    vector<iovec> iovecs{{_buf.data() + pos, first}};
+    if (len > first) {
+        iovecs.push_back({_buf.data(), len - first});
+    }
+    const size_t ret = fd.read(iovecs);
     this->nwrite += ret;
     return ret;
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
+    const size_t count = min(len, buffer_size());
     string ret;
-    size_t count = len > this->buf.size() ? this->buf.size():len;
-    for (size_t i = 0; i < count; i++)
-        ret += this->buf[i];
+    ret.reserve(count);
+    copy_out(ret, count);
+    return ret;
+}
+
+//! \param[in] len bytes will be referenced from the output side of the buffer
+BufferViewList ByteStream::peek_buffers(const size_t len) const {
+    BufferViewList ret;
+    size_t left = min(len, buffer_size());
+    if (_chunked) {
+        //writev最多接受IOV_MAX段,超过就会返回EINVAL;后面的chunk留给下一次peek
+        size_t views = 0;
+        for (const auto &chunk : _chunks.buffers()) {
+            if (!left || views == IOV_MAX) {
+                break;
+            }
+            const size_t n = min(left, chunk.size());
+            ret.append(chunk.str().substr(0, n));
+            left -= n;
+            views++;
+        }
+        return ret;
+    }
+    //和copy_out一样,最多分成读指针到缓冲区末尾,以及缓冲区开头两段
+    const size_t pos = nread & _mask;
+    const size_t first = min(left, _buf.size() - pos);
+    ret.append({_buf.data() + pos, first});
+    ret.append({_buf.data(), left - first});
     return ret;
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
-    size_t count = len > this->buf.size() ? buf.size():len;
+    //nread和nwrite本身就是环形缓冲区的读写指针,pop只需要移动nread即可
+    const size_t count = min(len, buffer_size());
+    if (_chunked) {
+        _chunks.remove_prefix(count);
+    }
     this->nread += count;
-    while(count--)
-        this->buf.pop_front();
+}
+
+size_t ByteStream::write_to(FileDescriptor &fd, const size_t limit) {
+    const size_t ret = fd.write(peek_buffers(min(limit, buffer_size())), false);
+    pop_output(ret);
+    return ret;
+}
+
+BufferList ByteStream::read_buffers(const size_t len) {
+    if (!_chunked) {
+        return BufferList(read(len));
+    }
+    BufferList ret;
+    const size_t count = min(len, buffer_size());
+    size_t left = count;
+    for (const auto &chunk : _chunks.buffers()) {
+        if (!left) {
+            break;
+        }
+        Buffer piece = chunk;
+        if (piece.size() > left) {
+            piece.remove_suffix(piece.size() - left);
+        }
+        left -= piece.size();
+        ret.append(move(piece));
+    }
+    pop_output(count);
+    return ret;
 }
 
 //仔细研究了一手才知道,这个api相当于是让发送方表明自己以后不发消息了.
@@ -66,11 +205,11 @@ bool ByteStream::input_ended() const {
 }
 
 size_t ByteStream::buffer_size() const {
-    return this->buf.size();
+    return this->nwrite - this->nread;
 }
 
 bool ByteStream::buffer_empty() const {
-    return this->buf.size() == 0;
+    return this->nwrite == this->nread;
 }
 
 //这个api是是否读到了头,只有当前buf是空的,并且发送方再也不发送东西了,才相当于是大结束.
@@ -87,5 +226,22 @@ size_t ByteStream::bytes_read() const {
 }
 
 size_t ByteStream::remaining_capacity() const {
-    return this->cap - this->buf.size();
+    return this->cap - buffer_size();
+}
+
+void ByteStream::set_capacity(const size_t capacity) {
+    cap = max(capacity, buffer_size());
+    if (_chunked || round_up_pow2(cap) == _buf.size()) {
+        return;
+    }
+    //_mask变了之后每个字节的位置都不一样,把还没有读的字节按新的_mask搬到新的缓冲区里
+    string pending;
+    pending.reserve(buffer_size());
+    copy_out(pending, buffer_size());
+    _buf = vector<char>(round_up_pow2(cap));
+    _mask = _buf.size() - 1;
+    const size_t pos = nread & _mask;
+    const size_t first = min(pending.size(), _buf.size() - pos);
+    memcpy(_buf.data() + pos, pending.data(), first);
+    memcpy(_buf.data(), pending.data() + first, pending.size() - first);
 }
@@ -1,12 +1,16 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
 #include <cstddef>
 #include <cstdint>
-#include <deque>
-#include <list>
+#include <limits>
 #include <string>
 #include <utility>
+#include <vector>
+
+class FileDescriptor;
 
 //! \brief An in-order byte stream.
 
@@ -16,16 +20,30 @@
 class ByteStream {
   private:
     // Your code here -- add private members as necessary.
-    std::deque<char>buf = {};
+    bool _chunked;           //是否是chunked模式:直接保存写入的Buffer的引用,而不是拷贝到环形缓冲区中
+    std::vector<char> _buf;  //环形缓冲区,长度为不小于cap的2的幂,下标通过 & _mask 取得(chunked模式下不使用)
+    size_t _mask;            //_buf.size() - 1
+    BufferList _chunks{};    //chunked模式下保存的所有还没有被读取的Buffer
     bool _eof = false;
     size_t nread = 0;
     size_t nwrite = 0;
     size_t cap;
     bool _error = false;  //!< Flag indicating that the stream suffered an error.
 
+    //从nwrite对应的位置开始,把data的前len个字节拷贝到环形缓冲区中(最多两次memcpy),调用者保证空间足够
+    void copy_in(const char *data, const size_t len);
+
+    //从nread对应的位置开始,把环形缓冲区中的前len个字节拷贝到out中(最多两次append),调用者保证len不超过buffer_size()
+    void copy_out(std::string &out, const size_t len) const;
+
   public:
+    //! Largest chunk that read_from() reads at once in chunked mode
+    static constexpr size_t MAX_READ_CHUNK = 1024 * 1024;
+
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    //! \param chunked if `true`, the stream holds references to the written Buffers
+    //! instead of copying their bytes into a ring buffer
+    ByteStream(const size_t capacity, const bool chunked = false);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -35,9 +53,33 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write `len` bytes starting at `data` into the stream. Write as many
+    //! as will fit, and return how many were written.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const char *data, const size_t len);
+
+    //! Write a Buffer into the stream. Write as many bytes as will fit,
+    //! and return how many were written.
+    //! \note In chunked mode the bytes are not copied; the stream keeps a reference to `data`.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
+    //! Read up to `limit` bytes from `fd` straight into the stream (never more than will fit)
+    //! \note Uses one [readv(2)](\ref man2::readv) into the ring buffer's free space, or in chunked mode
+    //! into a new uninitialized chunk of at most MAX_READ_CHUNK bytes.
+    //! \returns the number of bytes read from `fd`
+    size_t read_from(FileDescriptor &fd, const size_t limit = std::numeric_limits<size_t>::max());
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
+    //! \returns the number of bytes the stream can hold
+    size_t capacity() const { return cap; }
+
+    //! Change the number of bytes the stream can hold (never below buffer_size())
+    //! \note The ring buffer is reallocated when its power-of-two size changes, so shrinking frees memory
+    void set_capacity(const size_t capacity);
+
     //! Signal that the byte stream has reached its ending
     void end_input();
 
@@ -52,9 +94,23 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \note The views point into the stream's own storage and are only valid
+    //! until the next call that modifies the stream. Typical use is to hand them to
+    //! FileDescriptor::write (a single [writev(2)](\ref man2::writev)) and then
+    //! pop_output() however many bytes were actually written.
+    //! \returns a list of at most two views (or one per chunk in chunked mode, but no more than IOV_MAX,
+    //! so fewer than `len` bytes may be returned even if the stream holds them)
+    BufferViewList peek_buffers(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
+    //! Write up to `limit` bytes from the stream to `fd` without blocking, and pop what was written
+    //! \note Uses one [writev(2)](\ref man2::writev) over peek_buffers().
+    //! \returns the number of bytes written to `fd`
+    size_t write_to(FileDescriptor &fd, const size_t limit = std::numeric_limits<size_t>::max());
+
     //! Read (i.e., copy and then pop) the next "len" bytes of the stream
     //! \returns a vector of bytes read
     std::string read(const size_t len) {
@@ -63,6 +119,15 @@ class ByteStream {
         return ret;
     }
 
+    //! Read (i.e., reference and then pop) the next "len" bytes of the stream
+    //! \note In chunked mode the returned Buffers share storage with the written ones;
+    //! otherwise this is equivalent to read().
+    //! \returns a list of buffers holding the bytes read
+    BufferList read_buffers(const size_t len);
+
+    //! \returns `true` if the stream stores Buffer chunks instead of copying into a ring buffer
+    bool chunked() const { return _chunked; }
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -0,0 +1,325 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+unique_ptr<CongestionControl> CongestionControl::make(const Algorithm algorithm, const size_t mss) {
+    switch (algorithm) {
+        case Algorithm::None:
+            return make_unique<NoCongestionControl>();
+        case Algorithm::NewReno:
+            return make_unique<NewReno>(mss);
+        case Algorithm::Cubic:
+            return make_unique<Cubic>(mss);
+        case Algorithm::Bbr:
+            return make_unique<Bbr>(mss);
+    }
+    return make_unique<NewReno>(mss);
+}
+
+//初始窗口按照RFC 6928取10个mss(但不超过14600字节,至少两个mss)
+static size_t initial_window(const size_t mss) { return min(10 * mss, max<size_t>(2 * mss, 14600)); }
+
+NewReno::NewReno(const size_t mss) : _mss(mss), _cwnd(initial_window(mss)) {}
+
+void NewReno::on_ack(const AckEvent &ack) {
+    if (ack.in_recovery) {
+        //快速恢复期间窗口由发送方按照RFC 6582调整
+        return;
+    }
+    if (_cwnd < _ssthresh) {
+        //慢启动:每个ack最多增加一个mss(RFC 3465, L = 1)
+        _cwnd += min(ack.acked_bytes, _mss);
+        return;
+    }
+    //拥塞避免:每确认一整个cwnd的数据,cwnd增加一个mss
+    _acked_in_avoidance += ack.acked_bytes;
+    if (_acked_in_avoidance >= _cwnd) {
+        _acked_in_avoidance -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void NewReno::reduce(const size_t bytes_in_flight) {
+    _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+    _acked_in_avoidance = 0;
+}
+
+void NewReno::on_loss(const size_t bytes_in_flight) {
+    reduce(bytes_in_flight);
+    _cwnd = _ssthresh;
+}
+
+void NewReno::on_rto(const size_t bytes_in_flight) {
+    reduce(bytes_in_flight);
+    _cwnd = _mss;
+}
+
+//RFC 8312中的cubic函数以mss和秒为单位,这里的窗口以字节为单位,时间以ms为单位
+Cubic::Cubic(const size_t mss) : _mss(mss), _cwnd(initial_window(mss)) {}
+
+//对外只给出整数个mss的窗口,否则每个ack都会因为窗口增长了几个字节而多发出一个很小的段
+size_t Cubic::cwnd() const { return max<size_t>(1, static_cast<size_t>(_cwnd / static_cast<double>(_mss))) * _mss; }
+
+size_t Cubic::ssthresh() const {
+    if (_ssthresh >= static_cast<double>(numeric_limits<size_t>::max())) {
+        return numeric_limits<size_t>::max();
+    }
+    return static_cast<size_t>(_ssthresh);
+}
+
+void Cubic::on_ack(const AckEvent &ack) {
+    if (ack.rtt.has_value()) {
+        _min_rtt = min(_min_rtt.value_or(ack.rtt.value()), ack.rtt.value());
+    }
+    if (ack.in_recovery) {
+        return;
+    }
+    if (_cwnd < _ssthresh) {
+        slow_start(ack);
+    } else {
+        congestion_avoidance(ack);
+    }
+}
+
+void Cubic::slow_start(const AckEvent &ack) {
+    _cwnd += min(ack.acked_bytes, _mss);
+
+    if (ack.ackno > _round_end) {
+        //上一轮发出的数据都得到了确认,开始新的一轮
+        _last_round_min_rtt = _round_min_rtt;
+        _round_min_rtt = numeric_limits<uint64_t>::max();
+        _rtt_samples = 0;
+        _round_end = ack.next_seqno;
+    }
+    if (!ack.rtt.has_value()) {
+        return;
+    }
+    _round_min_rtt = min(_round_min_rtt, ack.rtt.value());
+    ++_rtt_samples;
+
+    //本轮的rtt比上一轮增大了至少eta(上一轮rtt的1/8,限制在[4ms, 16ms]之间),说明瓶颈的队列已经开始堆积
+    if (_rtt_samples >= N_RTT_SAMPLE && _last_round_min_rtt != numeric_limits<uint64_t>::max() &&
+        _round_min_rtt != numeric_limits<uint64_t>::max()) {
+        const uint64_t eta = clamp(_last_round_min_rtt / 8, MIN_RTT_THRESH, MAX_RTT_THRESH);
+        if (_round_min_rtt >= _last_round_min_rtt + eta) {
+            _ssthresh = _cwnd;
+        }
+    }
+}
+
+void Cubic::congestion_avoidance(const AckEvent &ack) {
+    const double mss = _mss;
+    if (!_epoch_start.has_value()) {
+        //丢包后的第一个ack,开始新的一轮拥塞避免
+        _epoch_start = ack.now;
+        if (_cwnd < _w_max) {
+            _k = cbrt((_w_max - _cwnd) / mss / C);
+            _origin = _w_max;
+        } else {
+            _k = 0;
+            _origin = _cwnd;
+        }
+        _w_est = _cwnd;
+    }
+
+    //W_cubic(t) = C * (t - K)^3 + W_max
+    const auto w_cubic = [&](const double t) { return _origin + C * (t - _k) * (t - _k) * (t - _k) * mss; };
+    const double t = static_cast<double>(ack.now - _epoch_start.value()) / 1000;
+    const double rtt = static_cast<double>(_min_rtt.value_or(0)) / 1000;
+
+    //Reno在同样的时间内能达到的窗口,每个rtt增加3(1-BETA)/(1+BETA)个mss
+    _w_est += 3 * (1 - BETA) / (1 + BETA) * mss * static_cast<double>(ack.acked_bytes) / _cwnd;
+
+    if (w_cubic(t) < _w_est) {
+        //TCP友好区域:cubic增长得比Reno还慢,按照Reno的速度增长
+        _cwnd = max(_cwnd, _w_est);
+    } else {
+        //目标是一个rtt之后cubic函数的值,但每个rtt最多增长到1.5倍
+        const double target = clamp(w_cubic(t + rtt), _cwnd, 1.5 * _cwnd);
+        _cwnd += (target - _cwnd) * static_cast<double>(ack.acked_bytes) / _cwnd;
+    }
+}
+
+void Cubic::reduce(const size_t bytes_in_flight) {
+    //fast convergence:如果这次丢包时的窗口比上次还小,说明有新的流加入,主动多让出一些带宽
+    _w_max = _cwnd < _w_max ? _cwnd * (1 + BETA) / 2 : _cwnd;
+    //按照RFC 9438用在途的数据而不是cwnd计算ssthresh:连续超时的时候cwnd已经是一个mss了,
+    //用cwnd的话ssthresh会一直停留在最小值
+    _ssthresh = max(static_cast<double>(bytes_in_flight) * BETA, 2.0 * _mss);
+    _epoch_start.reset();
+}
+
+void Cubic::on_loss(const size_t bytes_in_flight) {
+    reduce(bytes_in_flight);
+    _cwnd = _ssthresh;
+}
+
+void Cubic::on_rto(const size_t bytes_in_flight) {
+    reduce(bytes_in_flight);
+    _cwnd = _mss;
+}
+
+// ProbeBW的增益循环:一轮以1.25倍的速率探测更多的带宽,下一轮以0.75倍的速率排空探测时排起来的队列,然后匀速6轮
+static constexpr double PROBE_BW_GAINS[] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+static constexpr unsigned PROBE_BW_CYCLE = sizeof(PROBE_BW_GAINS) / sizeof(PROBE_BW_GAINS[0]);
+
+Bbr::Bbr(const size_t mss) : _mss(mss), _cwnd(initial_window(mss)) {}
+
+size_t Bbr::bdp() const {
+    if (_bw_samples.empty() || !_min_rtt.has_value()) {
+        return initial_window(_mss);
+    }
+    //rtt的精度只有1ms,在本地回环上可能测出0
+    return static_cast<size_t>(btl_bw() * static_cast<double>(max<uint64_t>(_min_rtt.value(), 1)));
+}
+
+optional<double> Bbr::pacing_rate() const {
+    if (_bw_samples.empty()) {
+        //还没有带宽的估计值,先不限速,由初始窗口限制发送
+        return {};
+    }
+    return _pacing_gain * btl_bw();
+}
+
+void Bbr::on_ack(const AckEvent &ack) {
+    update_round(ack);
+    update_bw(ack);
+    check_full_pipe(ack);
+
+    if (_mode == Mode::Startup && _filled_pipe) {
+        _mode = Mode::Drain;
+        _pacing_gain = 1 / HIGH_GAIN;
+        _cwnd_gain = HIGH_GAIN;
+    }
+    if (_mode == Mode::Drain && ack.bytes_in_flight <= bdp()) {
+        enter_probe_bw(ack.now);
+    }
+    if (_mode == Mode::ProbeBW) {
+        update_probe_bw_cycle(ack);
+    }
+
+    update_min_rtt(ack);
+    update_cwnd(ack);
+}
+
+void Bbr::update_round(const AckEvent &ack) {
+    _round_start = ack.ackno > _round_end;
+    if (_round_start) {
+        ++_round;
+        _round_end = ack.next_seqno;
+    }
+}
+
+void Bbr::update_bw(const AckEvent &ack) {
+    if (!ack.delivery_rate.has_value()) {
+        return;
+    }
+    const double rate = ack.delivery_rate.value();
+    //发送方没数据可发的时候测到的速率偏低,只有它比当前的估计值还大时才有意义
+    if (ack.app_limited && rate < btl_bw()) {
+        return;
+    }
+    while (!_bw_samples.empty() && _bw_samples.back().second <= rate) {
+        _bw_samples.pop_back();
+    }
+    _bw_samples.emplace_back(_round, rate);
+    while (_bw_samples.front().first + BW_WINDOW_ROUNDS <= _round) {
+        _bw_samples.pop_front();
+    }
+}
+
+void Bbr::check_full_pipe(const AckEvent &ack) {
+    if (_filled_pipe || !_round_start || ack.app_limited || _bw_samples.empty()) {
+        return;
+    }
+    if (btl_bw() >= _full_bw * 1.25) {
+        //带宽还在增长
+        _full_bw = btl_bw();
+        _full_bw_rounds = 0;
+        return;
+    }
+    if (++_full_bw_rounds >= 3) {
+        _filled_pipe = true;
+    }
+}
+
+void Bbr::enter_probe_bw(const uint64_t now) {
+    _mode = Mode::ProbeBW;
+    _pacing_gain = 1;
+    _cwnd_gain = CWND_GAIN;
+    //从匀速的阶段开始(原版BBR随机选择一个阶段,这里为了结果可重复固定下来)
+    _cycle_index = 2;
+    _cycle_stamp = now;
+}
+
+void Bbr::update_probe_bw_cycle(const AckEvent &ack) {
+    bool next = ack.now - _cycle_stamp > _min_rtt.value_or(0);
+    if (_pacing_gain > 1) {
+        //探测阶段至少要让在途的数据达到增益对应的量
+        next = next && ack.bytes_in_flight >= static_cast<size_t>(_pacing_gain * static_cast<double>(bdp()));
+    } else if (_pacing_gain < 1) {
+        //排空阶段一旦在途的数据回落到bdp就可以提前结束
+        next = next || ack.bytes_in_flight <= bdp();
+    }
+    if (next) {
+        _cycle_index = (_cycle_index + 1) % PROBE_BW_CYCLE;
+        _cycle_stamp = ack.now;
+        _pacing_gain = PROBE_BW_GAINS[_cycle_index];
+    }
+}
+
+void Bbr::update_min_rtt(const AckEvent &ack) {
+    const bool expired = ack.now > _min_rtt_stamp + MIN_RTT_WINDOW_MS;
+    if (ack.rtt.has_value() && (!_min_rtt.has_value() || ack.rtt.value() <= _min_rtt.value() || expired)) {
+        _min_rtt = ack.rtt;
+        _min_rtt_stamp = ack.now;
+    }
+
+    if (expired && _mode != Mode::ProbeRTT) {
+        //很久没有测到更小的rtt了,可能是一直有排队,把在途的数据减少到几个段重新测一次
+        _mode = Mode::ProbeRTT;
+        _pacing_gain = 1;
+        _prior_cwnd = max(_prior_cwnd, _cwnd);
+        _probe_rtt_done.reset();
+    }
+    if (_mode != Mode::ProbeRTT) {
+        return;
+    }
+    if (!_probe_rtt_done.has_value() && ack.bytes_in_flight <= MIN_CWND_SEGMENTS * _mss) {
+        _probe_rtt_done = ack.now + PROBE_RTT_MS;
+        _probe_rtt_round = _round;
+    } else if (_probe_rtt_done.has_value() && ack.now >= _probe_rtt_done.value() && _round > _probe_rtt_round) {
+        _min_rtt_stamp = ack.now;
+        _cwnd = max(_cwnd, _prior_cwnd);
+        _prior_cwnd = 0;
+        if (_filled_pipe) {
+            enter_probe_bw(ack.now);
+        } else {
+            _mode = Mode::Startup;
+            _pacing_gain = HIGH_GAIN;
+            _cwnd_gain = HIGH_GAIN;
+        }
+    }
+}
+
+void Bbr::update_cwnd(const AckEvent &ack) {
+    const size_t min_cwnd = MIN_CWND_SEGMENTS * _mss;
+    if (_mode == Mode::ProbeRTT) {
+        _cwnd = min_cwnd;
+        return;
+    }
+    const size_t target = max(static_cast<size_t>(_cwnd_gain * static_cast<double>(bdp())), min_cwnd);
+    if (_filled_pipe) {
+        _cwnd = min(_cwnd + ack.acked_bytes, target);
+    } else if (_cwnd < target || _bw_samples.empty()) {
+        //管道还没满的时候像慢启动一样增长
+        _cwnd += ack.acked_bytes;
+    }
+    _cwnd = max(_cwnd, min_cwnd);
+}
+
+//超时后先只发一个段,之后的ack会让窗口按照确认的数据量很快地恢复到模型的目标值
+void Bbr::on_rto(const size_t) { _cwnd = _mss; }
@@ -0,0 +1,249 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
+
+//! \brief Interface for the TCPSender's congestion-control algorithm
+//!
+//! The TCPSender reports each ACK of new data, each loss and each retransmission timeout,
+//! and never keeps more than min(cwnd(), receiver's window) bytes in flight.
+//! All quantities are in bytes of sequence space.
+class CongestionControl {
+  public:
+    //! Algorithms the TCPSender can use (see TCPConfig::congestion_control)
+    enum class Algorithm {
+        None,     //!< Send whatever the receiver's window allows
+        NewReno,  //!< Slow start and congestion avoidance (RFC 5681, RFC 6582)
+        Cubic,    //!< CUBIC window growth (RFC 8312) with a delay-based (HyStart) slow-start exit
+        Bbr,      //!< Model-based: paces at the estimated bottleneck bandwidth (BBR v1)
+    };
+
+    //! What the sender knows when an ACK acknowledges new data
+    struct AckEvent {
+        uint64_t now = 0;               //!< The sender's clock (total of its tick() arguments), in milliseconds
+        size_t acked_bytes = 0;         //!< Bytes newly acknowledged by this ACK
+        size_t bytes_in_flight = 0;     //!< Bytes still outstanding after this ACK
+        std::optional<uint64_t> rtt{};  //!< Round-trip time measured by this ACK (never from a retransmission)
+        uint64_t ackno = 0;             //!< The (absolute) acknowledgment number
+        uint64_t next_seqno = 0;        //!< The (absolute) sequence number of the next byte the sender will send
+        std::optional<double> delivery_rate{};  //!< Delivery rate measured by this ACK, in bytes per millisecond
+        bool app_limited = false;  //!< The rate was measured while the sender had run out of data to send
+        bool in_recovery = false;  //!< The ACK arrived during fast recovery, so the window should not grow
+    };
+
+    //! Create the congestion control for `algorithm`
+    //! \param mss the largest payload the sender puts in one segment
+    static std::unique_ptr<CongestionControl> make(const Algorithm algorithm, const size_t mss);
+
+    //! \brief An ACK acknowledged new data
+    virtual void on_ack(const AckEvent &ack) = 0;
+
+    //! \brief A loss was detected without waiting for a timeout (e.g. by duplicate ACKs)
+    virtual void on_loss(const size_t bytes_in_flight) = 0;
+
+    //! \brief The retransmission timer expired
+    virtual void on_rto(const size_t bytes_in_flight) = 0;
+
+    //! \brief The congestion window
+    virtual size_t cwnd() const = 0;
+
+    //! \brief The slow-start threshold
+    virtual size_t ssthresh() const = 0;
+
+    //! \brief The rate at which to send new data, in bytes per millisecond
+    //! \returns nothing if new data may be sent as fast as the windows allow
+    virtual std::optional<double> pacing_rate() const { return {}; }
+
+    virtual ~CongestionControl() = default;
+};
+
+//! \brief No congestion control: the window is unlimited, so only the receiver's window applies
+class NoCongestionControl : public CongestionControl {
+  public:
+    void on_ack(const AckEvent &) override {}
+    void on_loss(const size_t) override {}
+    void on_rto(const size_t) override {}
+    size_t cwnd() const override { return std::numeric_limits<size_t>::max(); }
+    size_t ssthresh() const override { return std::numeric_limits<size_t>::max(); }
+};
+
+//! \brief Reno/NewReno congestion control (RFC 5681)
+//!
+//! Slow start grows the window by up to one MSS per ACK, congestion avoidance by one MSS per window
+//! of acknowledged data. A loss halves the window; a timeout shrinks it to one MSS.
+class NewReno : public CongestionControl {
+  private:
+    size_t _mss;
+    size_t _cwnd;                                           //当前的拥塞窗口
+    size_t _ssthresh = std::numeric_limits<size_t>::max();  //慢启动阈值,一开始认为是无穷大
+    size_t _acked_in_avoidance = 0;  //拥塞避免阶段累计确认的字节数,每满一个cwnd就把cwnd增加一个mss
+
+    //发生丢包时,ssthresh设为在途数据的一半,但至少是两个mss
+    void reduce(const size_t bytes_in_flight);
+
+  public:
+    //! \param mss the largest payload the sender puts in one segment
+    explicit NewReno(const size_t mss);
+
+    void on_ack(const AckEvent &ack) override;
+    void on_loss(const size_t bytes_in_flight) override;
+    void on_rto(const size_t bytes_in_flight) override;
+    size_t cwnd() const override { return _cwnd; }
+    size_t ssthresh() const override { return _ssthresh; }
+};
+
+//! \brief CUBIC congestion control (RFC 8312, with the RFC 9438 update that bases ssthresh on the flight size)
+//!
+//! After a loss the window grows along a cubic function of the time since the loss: quickly at
+//! first, flattening out near the window where the loss happened (W_max), then probing beyond it.
+//! The window never grows slower than Reno's would. Slow start ends early, before any loss, once
+//! the round-trip time of a round rises noticeably above the previous round's (HyStart's delay-increase
+//! test). Slow start then ends for good: there is no Conservative Slow Start phase as in HyStart++.
+class Cubic : public CongestionControl {
+  public:
+    static constexpr double C = 0.4;     //!< Scaling constant of the cubic function, in MSS/s^3
+    static constexpr double BETA = 0.7;  //!< Multiplicative decrease factor
+
+    //! \name Delay-increase test parameters
+    //!@{
+    static constexpr unsigned N_RTT_SAMPLE = 8;     //!< RTT samples needed in a round before it can end slow start
+    static constexpr uint64_t MIN_RTT_THRESH = 4;   //!< Smallest RTT increase (ms) that ends slow start
+    static constexpr uint64_t MAX_RTT_THRESH = 16;  //!< Largest RTT increase (ms) needed to end slow start
+    //!@}
+
+  private:
+    size_t _mss;
+    double _cwnd;  //拥塞窗口,用double是因为拥塞避免阶段每个ack只增加很小的一部分
+    double _ssthresh = std::numeric_limits<double>::max();  //慢启动阈值
+    double _w_max = 0;                                      //上一次丢包时的窗口
+    std::optional<uint64_t> _epoch_start{};  //本轮拥塞避免开始的时间,丢包后清空,下一个ack时重新设置
+    double _k = 0;                           //cubic函数回到_origin所需的时间,单位s
+    double _origin = 0;                      //cubic函数的平台位置
+    double _w_est = 0;                       //按照Reno的增长速度估计的窗口(TCP友好区域)
+    std::optional<uint64_t> _min_rtt{};      //目前见过的最小rtt
+
+    //HyStart按轮次比较rtt:一轮从某个ack开始,到确认了这个ack时已经发出的全部数据为止
+    uint64_t _round_end = 0;                                              //本轮的结束位置(absolute seqno)
+    uint64_t _round_min_rtt = std::numeric_limits<uint64_t>::max();       //本轮中的最小rtt
+    uint64_t _last_round_min_rtt = std::numeric_limits<uint64_t>::max();  //上一轮中的最小rtt
+    unsigned _rtt_samples = 0;                                            //本轮中采样的rtt个数
+
+    //慢启动阶段的ack,同时检查rtt是否已经增大到应该退出慢启动
+    void slow_start(const AckEvent &ack);
+
+    //拥塞避免阶段的ack
+    void congestion_avoidance(const AckEvent &ack);
+
+    //丢包或超时:记录W_max,把ssthresh设为BETA * 在途的数据
+    void reduce(const size_t bytes_in_flight);
+
+  public:
+    //! \param mss the largest payload the sender puts in one segment
+    explicit Cubic(const size_t mss);
+
+    void on_ack(const AckEvent &ack) override;
+    void on_loss(const size_t bytes_in_flight) override;
+    void on_rto(const size_t bytes_in_flight) override;
+    size_t cwnd() const override;
+    size_t ssthresh() const override;
+
+    //! \brief The window at the most recent loss (W_max), or 0 before the first loss
+    size_t w_max() const { return static_cast<size_t>(_w_max); }
+};
+
+//! \brief BBR-style model-based congestion control (BBR v1)
+//!
+//! Instead of reacting to loss, BBR builds a model of the path: the bottleneck bandwidth (the
+//! largest delivery rate seen in the last BW_WINDOW_ROUNDS round trips) and the round-trip
+//! propagation delay (the smallest RTT seen in the last MIN_RTT_WINDOW_MS). It paces new data at
+//! about the bottleneck bandwidth and keeps about CWND_GAIN bandwidth-delay products in flight,
+//! so the bottleneck's queue stays short however deep its buffer is.
+class Bbr : public CongestionControl {
+  public:
+    //! The phases of BBR
+    enum class Mode {
+        Startup,   //!< Double the sending rate every round trip until the bandwidth stops growing
+        Drain,     //!< Drain the queue that Startup built
+        ProbeBW,   //!< Cruise at the estimated bandwidth, briefly probing above and below it every round trip
+        ProbeRTT,  //!< Shrink the flight to a few segments to measure the propagation delay again
+    };
+
+    static constexpr double HIGH_GAIN = 2.885;            //!< Startup's pacing and window gain (2/ln 2)
+    static constexpr double CWND_GAIN = 2;                //!< Window gain outside Startup and Drain
+    static constexpr unsigned BW_WINDOW_ROUNDS = 10;      //!< Round trips the bandwidth estimate remembers
+    static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;  //!< How long the propagation delay estimate lasts
+    static constexpr uint64_t PROBE_RTT_MS = 200;         //!< Time spent with a small flight in ProbeRTT
+    static constexpr size_t MIN_CWND_SEGMENTS = 4;        //!< The window never shrinks below this many MSS
+
+  private:
+    size_t _mss;
+    Mode _mode = Mode::Startup;
+    size_t _cwnd;                        //拥塞窗口
+    double _pacing_gain = HIGH_GAIN;     //发送速率相对于估计带宽的倍数
+    double _cwnd_gain = HIGH_GAIN;       //拥塞窗口相对于bdp的倍数
+    size_t _prior_cwnd = 0;              //进入ProbeRTT之前的窗口,结束之后恢复
+
+    //最近BW_WINDOW_ROUNDS轮中的最大投递速率,用单调队列维护:<轮次, 速率>,速率从队头到队尾递减
+    std::deque<std::pair<uint64_t, double>> _bw_samples{};
+    std::optional<uint64_t> _min_rtt{};  //最小rtt
+    uint64_t _min_rtt_stamp = 0;         //测到_min_rtt的时间
+
+    //轮次:一轮从某个ack开始,到确认了这个ack时已经发出的全部数据为止
+    uint64_t _round = 0;
+    uint64_t _round_end = 0;
+    bool _round_start = false;  //当前的ack是不是开始了新的一轮
+
+    //Startup阶段,带宽连续3轮增长不到25%就认为管道已经满了
+    double _full_bw = 0;
+    unsigned _full_bw_rounds = 0;
+    bool _filled_pipe = false;
+
+    unsigned _cycle_index = 0;  // ProbeBW中当前处于增益循环的哪一个阶段
+    uint64_t _cycle_stamp = 0;  //进入这个阶段的时间
+
+    std::optional<uint64_t> _probe_rtt_done{};  // ProbeRTT在这个时间之后(并且又过了一轮)结束
+    uint64_t _probe_rtt_round = 0;
+
+    //估计的瓶颈带宽,单位是字节每毫秒,还没有采样时为0
+    double btl_bw() const { return _bw_samples.empty() ? 0 : _bw_samples.front().second; }
+
+    //带宽时延积,还没有估计值时取初始窗口
+    size_t bdp() const;
+
+    void update_round(const AckEvent &ack);
+    void update_bw(const AckEvent &ack);
+    void check_full_pipe(const AckEvent &ack);
+    void update_probe_bw_cycle(const AckEvent &ack);
+    void update_min_rtt(const AckEvent &ack);
+    void update_cwnd(const AckEvent &ack);
+
+    void enter_probe_bw(const uint64_t now);
+
+  public:
+    //! \param mss the largest payload the sender puts in one segment
+    explicit Bbr(const size_t mss);
+
+    void on_ack(const AckEvent &ack) override;
+    void on_loss(const size_t) override {}
+    void on_rto(const size_t) override;
+    size_t cwnd() const override { return _cwnd; }
+    size_t ssthresh() const override { return std::numeric_limits<size_t>::max(); }
+    std::optional<double> pacing_rate() const override;
+
+    //! \brief The current phase
+    Mode mode() const { return _mode; }
+
+    //! \brief The bottleneck bandwidth estimate, in bytes per millisecond (0 before the first sample)
+    double bottleneck_bandwidth() const { return btl_bw(); }
+
+    //! \brief The round-trip propagation delay estimate, in milliseconds
+    std::optional<uint64_t> min_rtt() const { return _min_rtt; }
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
@@ -1,5 +1,9 @@
 #include "stream_reassembler.hh"
 
+#include "util.hh"
+
+#include <cstring>
+
 // Dummy implementation of a stream reassembler.
 
 // For Lab 1, please replace with a real implementation that passes the
@@ -13,35 +17,6 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 using namespace std;
 
 
-Substring::Substring(const std::string &data, const uint64_t index) :_str(data),_hh(index),_tt(index + data.length()) {}
-
-bool Substring::mergeable(const Substring &other) const {
-    if (this->_hh > other._tt)
-        return false;
-
-    if (this->_tt < other._hh)
-        return false;
-
-    return true;
-}
-
-void Substring::doMerge(const Substring& other){
-    string prefix;
-    string suffix;
-    if(this->_hh > other._hh){
-        //应该由other作为头部
-        size_t prefix_length = this->_hh - other._hh;
-        prefix = other._str.substr(0, prefix_length);
-        this->_hh = other._hh;
-    }
-    if(this->_tt < other._tt){
-        size_t suffix_length = other._tt - this->_tt;
-        suffix = other._str.substr(other._str.length() - suffix_length, other._str.length());
-        this->_tt = other._tt;
-    }
-    this->_str = prefix + this->_str + suffix;
-}
-
 size_t StreamReassembler::get_window_size() const{
 /*
 运算逻辑:
@@ -58,86 +33,323 @@ size_t StreamReassembler::get_window_size() const{
     return _capacity - stream_out().buffer_size();
 }
 
-StreamReassembler::StreamReassembler(const size_t capacity) : _free_space(capacity),_capacity(capacity),_output(capacity) {}
+StreamReassembler::StreamReassembler(const size_t capacity, const bool chunked, const bool windowed)
+    : _max_fragments(max(MIN_FRAGMENTS, capacity / FRAGMENT_BYTES))
+    , _windowed(windowed)
+    , _capacity(capacity)
+    , _output(capacity, chunked) {
+    if (_windowed) {
+        grow_window(capacity);
+    }
+}
+
+void StreamReassembler::set_capacity(const size_t capacity) {
+    _capacity = capacity;
+    _output.set_capacity(capacity);
+    if (_windowed) {
+        grow_window(capacity);
+    }
+}
+
+void StreamReassembler::grow_window(const size_t capacity) {
+    //窗口至少64字节,这样位图的每个word都不会跨过窗口的边界
+    const size_t size = round_up_pow2(max<size_t>(capacity, 64));
+    if (size <= _window.size()) {
+        return;
+    }
+    vector<char> window(size);
+    vector<uint64_t> filled(size / 64);
+    const size_t mask = size - 1;
+    //乱序数据都在[_should_write_idx, _should_write_idx + 旧窗口的大小)之中,逐字节搬过去.窗口很少扩大,不用在意速度
+    for (uint64_t idx = _should_write_idx; _unassembled && idx < _should_write_idx + _window.size(); idx++) {
+        const size_t pos = idx & _mask;
+        if ((_filled[pos / 64] >> (pos % 64)) & 1) {
+            const size_t new_pos = idx & mask;
+            window[new_pos] = _window[pos];
+            filled[new_pos / 64] |= uint64_t{1} << (new_pos % 64);
+        }
+    }
+    _window = move(window);
+    _filled = move(filled);
+    _mask = mask;
+}
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    if(eof){
+    auto [begin, end] = accept(index, data.size(), eof);
+    if (in_order(begin, end)) {
+        begin += _output.write(data.data() + (begin - index), end - begin);
+        _should_write_idx = begin;
+    }
+    if (begin < end) {
+        if (_windowed) {
+            //windowed模式直接从data拷贝进窗口,不需要先包装成Buffer
+            store_window(data, index, begin, end);
+        } else {
+            store(Buffer(string(data)), index, begin, end);
+        }
+    }
+    if (_windowed) {
+        doWrite_window();
+    } else {
+        doWrite();
+    }
+}
+
+void StreamReassembler::push_substring(const Buffer &data, const size_t index, const bool eof) {
+    auto [begin, end] = accept(index, data.size(), eof);
+    if (in_order(begin, end)) {
+        //chunked模式下_output直接引用data的存储
+        Buffer piece = data;
+        piece.remove_prefix(begin - index);
+        piece.remove_suffix(index + data.size() - end);
+        begin += _output.write(move(piece));
+        _should_write_idx = begin;
+    }
+    if (begin < end) {
+        if (_windowed) {
+            store_window(data, index, begin, end);
+        } else {
+            store(data, index, begin, end);
+        }
+    }
+    if (_windowed) {
+        doWrite_window();
+    } else {
+        doWrite();
+    }
+}
+
+bool StreamReassembler::in_order(const uint64_t begin, const uint64_t end) {
+    ++_pushes;
+    //没有乱序数据在等待重组,并且新数据正好接在_should_write_idx上(accept已经裁掉了之前收过的部分),
+    //那么可以直接写进_output,不需要经过_segments或者窗口.
+    //如果_output只写进去了一部分,调用者会把剩下的部分照常存起来
+    if (begin < end && begin == _should_write_idx && _unassembled == 0) {
+        ++_in_order_pushes;
+        return true;
+    }
+    return false;
+}
+
+pair<uint64_t, uint64_t> StreamReassembler::accept(const uint64_t index, const size_t len, const bool eof) {
+    if (eof) {
+        //即使data只有一部分能放下,eof的位置也是确定的,等数据补齐之后再结束_output
         _have_eof = true;
-        _eof_pos = data.length() + index;
-        if(!data.length())
-            doWrite();
+        _eof_pos = index + len;
     }
-    uint64_t tmp_index = index;
-    if(data.length()+tmp_index <= _should_write_idx){
-        //检查data,如果data已经完全的被输出到_output中了,那么直接狗带
-        return;
+    //能接收的范围是[_should_write_idx, _should_write_idx + _output剩余的容量),
+    //这样已经重组的和还没有重组的字节加起来不会超过_capacity
+    return {max<uint64_t>(index, _should_write_idx),
+            min<uint64_t>(index + len, _should_write_idx + _output.remaining_capacity())};
+}
+
+//切片只是整个存储的一小部分(比如大段中间的小空洞)时拷贝出来,否则引用它会让整个存储一直留着
+static Buffer compact(Buffer piece) {
+    if (2 * piece.size() < piece.storage_size()) {
+        return Buffer(piece.copy());
     }
-    string tmp_data = data;
+    return piece;
+}
 
-    //如果data有一部分已经被写入_output了,那么截断这部分
-    if(tmp_index < _should_write_idx){
-        tmp_data = tmp_data.substr(_should_write_idx-tmp_index,tmp_data.length());
-        tmp_index = _should_write_idx;
+void StreamReassembler::store(const Buffer &data, const uint64_t index, uint64_t begin, const uint64_t end) {
+    //第一个首字节在begin之后的片段,它前面的那个片段可能盖住了begin
+    auto iter = _segments.upper_bound(begin);
+    if (iter != _segments.begin()) {
+        const auto &[prev_index, prev_data] = *std::prev(iter);
+        begin = max(begin, prev_index + prev_data.size());
     }
-    if(tmp_index >= _should_write_idx+_capacity){
-        //如果tmp_data的tmp_index超过了我们的容量,比如cap是10,我们当前_should_write_idx是1,说明我们希望1~10号char,
-        //所以如果出现了tmp_data的tmp_index=11,tmp_data.length()是10,但是1+10 <= 11,那么我们只能将tmp_data丢掉,反之我们一定能容纳一部分
-        return;
+    //依次把新数据裁剪到和后面片段之间的空洞里,直到越过end
+    while (begin < end) {
+        uint64_t hole_end = (iter == _segments.end()) ? end : min(end, iter->first);
+        if (begin < hole_end && _segments.size() >= _max_fragments) {
+            //片段数已经到上限了:丢掉离_should_write_idx最远的那个片段给新数据腾位置.
+            //如果新数据本身就是最远的,那么丢掉新数据剩下的部分(发送方之后会重传).
+            //begin == _should_write_idx的数据总是比所有片段都近,所以接上的数据一定能存下,流不会卡住
+            const auto last = std::prev(_segments.end());
+            ++_dropped_fragments;
+            if (last->first < begin) {
+                break;
+            }
+            if (last == iter) {
+                iter = _segments.end();
+                hole_end = end;
+            }
+            _unassembled -= last->second.size();
+            _segments.erase(last);
+        }
+        if (begin < hole_end) {
+            Buffer piece = data;
+            piece.remove_prefix(begin - index);
+            piece.remove_suffix(index + data.size() - hole_end);
+            _segments.emplace_hint(iter, begin, compact(move(piece)));
+            _unassembled += hole_end - begin;
+        }
+        if (iter == _segments.end()) {
+            break;
+        }
+        begin = max(begin, iter->first + iter->second.size());
+        ++iter;
     }
+}
 
-    if(_free_space < tmp_data.length() || index + tmp_data.length() > _should_write_idx + _capacity){
-        //如果不能完全的放下,那么需要截断一部分的字符串
-        //从lab2发现的bug= =...例如cap是2,我们希望放"abc",先放入"bc"的话其实只应该存储"b"
-        size_t cap_len = _capacity-(index-_should_write_idx); 
-        size_t miner = min(cap_len,_free_space);
-        tmp_data = tmp_data.substr(0,miner);
-    }
-    //如果可以放下,并且当前tmp_data的eof为true的话,说明将tmp_data写到输入流就算写完了,所以设置eof
-    auto new_ss = Substring(tmp_data,tmp_index);
-    for(auto iter = _substring_set.begin() ; iter != _substring_set.end();){
-        if(new_ss.mergeable(*iter)){
-            //如果可以和当前的存在的substring融合,那么融合一手
-            new_ss.doMerge(*iter);
-            _current_len -= iter->strLen();
-            _free_space += iter->strLen();
-            iter = _substring_set.erase(iter);
-        }else{
-            iter++;
+void StreamReassembler::doWrite() {
+    //从_segments的头部开始,把和_should_write_idx接上的片段依次写进_output
+    while (!_segments.empty() && _segments.begin()->first == _should_write_idx) {
+        auto iter = _segments.begin();
+        Buffer piece = move(iter->second);
+        _segments.erase(iter);
+        const size_t nw = _output.write(piece);
+        _unassembled -= nw;
+        _should_write_idx += nw;
+        if (nw < piece.size()) {
+            //_output只写进去了一部分,剩下的以新的下标放回去
+            piece.remove_prefix(nw);
+            _segments.emplace_hint(_segments.begin(), _should_write_idx, compact(move(piece)));
+            break;
         }
     }
-    _substring_set.insert(new_ss);
-    _free_space -= new_ss.strLen();
-    _current_len += new_ss.strLen();
-    doWrite();
+    if (_have_eof && _should_write_idx == _eof_pos) {
+        _output.end_input();
+    }
+}
+
+namespace {
+
+//对位图中下标在[begin, end)(对mask取模之后)的那些bit,按word依次调用f(word, 这个word中属于范围的bit)
+template <typename F>
+void for_each_word(vector<uint64_t> &bits, const size_t mask, uint64_t begin, const uint64_t end, F &&f) {
+    while (begin < end) {
+        const size_t pos = begin & mask;
+        const size_t shift = pos % 64;
+        const size_t n = min<uint64_t>(64 - shift, end - begin);
+        const uint64_t word_mask = (n == 64 ? ~uint64_t{0} : ((uint64_t{1} << n) - 1)) << shift;
+        f(bits[pos / 64], word_mask);
+        begin += n;
+    }
 }
 
-void StreamReassembler::doWrite(){
-    if (!_substring_set.empty() && _should_write_idx == _substring_set.begin()->_hh){
-        //如果当前需要写入的字符的idx和当前的substring_set中存储的substring的第一个字符的idx相等,那么进行write
-        auto iter = _substring_set.begin();
-        size_t nw = _output.write(_substring_set.begin()->_str);
-        if(nw == iter->_str.length()){
-            //如果把第一个substring全写了,那么删除掉第一个substring
-            _substring_set.erase(iter);
-        }else{
-            //如果把第一个substring的一部分写了,set不支持直接更改,需要先删掉再插入
-            Substring first = Substring(iter->_str.substr(nw, iter->_str.length()), iter->_hh + nw);
-            _substring_set.erase(iter);
-            _substring_set.insert(first);
+}  // namespace
+
+void StreamReassembler::store_window(const string_view data,
+                                     const uint64_t index,
+                                     const uint64_t begin,
+                                     const uint64_t end) {
+    //拷贝进窗口,最多在窗口末尾处分成两段.重复收到的字节内容相同,直接覆盖即可
+    const char *src = data.data() + (begin - index);
+    const size_t len = end - begin;
+    const size_t pos = begin & _mask;
+    const size_t first = min(len, _window.size() - pos);
+    memcpy(_window.data() + pos, src, first);
+    memcpy(_window.data(), src + first, len - first);
+
+    for_each_word(_filled, _mask, begin, end, [&](uint64_t &word, const uint64_t word_mask) {
+        _unassembled += __builtin_popcountll(word_mask & ~word);
+        word |= word_mask;
+    });
+}
+
+void StreamReassembler::doWrite_window() {
+    //从_should_write_idx开始数连续的1,每次看一个word
+    size_t run = 0;
+    while (run < _unassembled) {
+        const size_t pos = (_should_write_idx + run) & _mask;
+        const size_t shift = pos % 64;
+        //右移之后高位补的是0,所以shift > 0时~word中至少有shift个1,ones不会超过64 - shift.
+        //shift == 0并且整个word都是1的时候~word是0,__builtin_ctzll(0)没有定义,要单独处理
+        const uint64_t inv = ~(_filled[pos / 64] >> shift);
+        const size_t ones = inv ? __builtin_ctzll(inv) : 64;
+        run += ones;
+        if (ones < 64 - shift) {
+            break;
         }
-        _current_len -= nw;
+    }
+    run = min(run, _unassembled);
+
+    if (run) {
+        //一次性写进_output,同样最多分成两段
+        const size_t pos = _should_write_idx & _mask;
+        const size_t first = min(run, _window.size() - pos);
+        size_t nw = _output.write(_window.data() + pos, first);
+        if (nw == first) {
+            nw += _output.write(_window.data(), run - first);
+        }
+        for_each_word(_filled, _mask, _should_write_idx, _should_write_idx + nw, [](uint64_t &word, const uint64_t word_mask) {
+            word &= ~word_mask;
+        });
+        _unassembled -= nw;
         _should_write_idx += nw;
-        _free_space += nw;
     }
-    if(_have_eof && _should_write_idx == _eof_pos){
+    if (_have_eof && _should_write_idx == _eof_pos) {
         _output.end_input();
     }
 }
 
+vector<pair<uint64_t, uint64_t>> StreamReassembler::unassembled_ranges(const size_t max_ranges,
+                                                                      const uint64_t recent) const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    if (_unassembled == 0 || max_ranges == 0) {
+        return ranges;
+    }
+
+    //按顺序收集乱序数据的范围,相邻的合并成一个.已经有max_ranges个并且越过了recent就够用了
+    const auto enough = [&] { return ranges.size() >= max_ranges && ranges.back().second > recent; };
+    const auto add = [&](const uint64_t begin, const uint64_t end) {
+        if (!ranges.empty() && ranges.back().second == begin) {
+            ranges.back().second = end;
+        } else {
+            ranges.emplace_back(begin, end);
+        }
+    };
+
+    if (_windowed) {
+        //只有可接收范围内的bit才有意义,_should_write_idx之前的bit都已经被清掉了
+        const uint64_t limit = _should_write_idx + _output.remaining_capacity();
+        //从idx开始找第一个值为want的bit,每次看一个word;找不到返回limit
+        const auto find = [&](uint64_t idx, const bool want) {
+            while (idx < limit) {
+                const size_t pos = idx & _mask;
+                const size_t shift = pos % 64;
+                const uint64_t word = _filled[pos / 64] >> shift;
+                //找0的时候右移补进来的高位取反之后是1,所以要和64 - shift比较
+                const uint64_t bits = want ? word : ~word;
+                const size_t n = bits ? __builtin_ctzll(bits) : 64;
+                if (n < 64 - shift) {
+                    return min(idx + n, limit);
+                }
+                idx += 64 - shift;
+            }
+            return limit;
+        };
+        size_t seen = 0;
+        for (uint64_t idx = _should_write_idx; seen < _unassembled && !enough();) {
+            const uint64_t begin = find(idx, true);
+            if (begin >= limit) {
+                break;
+            }
+            idx = find(begin, false);
+            add(begin, idx);
+            seen += idx - begin;
+        }
+    } else {
+        for (auto iter = _segments.begin(); iter != _segments.end() && !enough(); ++iter) {
+            add(iter->first, iter->first + iter->second.size());
+        }
+    }
+
+    //包含recent的范围放到最前面,然后截断到max_ranges个
+    const auto latest = find_if(ranges.begin(), ranges.end(), [&](const auto &range) {
+        return range.first <= recent && recent < range.second;
+    });
+    if (latest != ranges.end()) {
+        rotate(ranges.begin(), latest, latest + 1);
+    }
+    ranges.resize(min(ranges.size(), max_ranges));
+    return ranges;
+}
 
-size_t StreamReassembler::unassembled_bytes() const { return this->_current_len; }
+size_t StreamReassembler::unassembled_bytes() const { return _unassembled; }
 
-bool StreamReassembler::empty() const { return _current_len; }
+bool StreamReassembler::empty() const { return _unassembled == 0; }
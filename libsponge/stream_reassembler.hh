@@ -3,48 +3,76 @@
 
 #include "byte_stream.hh"
 
+#include <algorithm>
 #include <cstdint>
-#include <set>
+#include <map>
 #include <string>
-
-class Substring {
-  public:
-    Substring() = default;
-    std::string _str;  //实际存储substring
-    size_t _hh = 0;    //本substring的首个字节位于大字符串的位置
-    size_t _tt = 0;    //本substring的最后一个字节的后面一个字节位于大字符串的位置
-    size_t strLen() const { return _tt - _hh; }
-    Substring(const std::string &data, const uint64_t index);
-
-    // mergeable 查看两个substring是否可以合并,比如首个
-    bool mergeable(const Substring &other) const;
-
-    // doMerge 将另一个Substring融合到本substring中,返回融合之后增加的长度
-    void doMerge(const Substring &other);
-
-    bool operator<(const Substring &other) const { return this->_hh < other._hh; }
-};
+#include <string_view>
+#include <utility>
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
+  public:
+    //! By default, at most one out-of-order fragment is held per this many bytes of capacity
+    //! (see set_max_fragments())...
+    static constexpr size_t FRAGMENT_BYTES = 256;
+    //! ...but the default limit is never lower than this
+    static constexpr size_t MIN_FRAGMENTS = 1024;
+
   private:
-    // Your code here -- add private members as necessary.
-    std::set<Substring> _substring_set = {};
-    size_t _current_len = 0;       //当前的所有substring的长度.
-    size_t _free_space;            //当前还剩下多少长度
+    //还没有写入_output的乱序数据,key是片段首字节的下标.片段之间互不重叠(插入时把新数据裁剪到空洞里),
+    //所以插入只需要用upper_bound找到前一个片段,再顺序看后面那几个和新数据重叠的片段即可.
+    //片段是Buffer的切片,和收到的segment共享存储,不会拷贝数据.
+    //只有不到存储一半大小的片段才拷贝出来,这样_segments占住的内存不超过_unassembled的两倍
+    std::map<uint64_t, Buffer> _segments = {};
+    size_t _max_fragments;           //_segments中最多的片段数,见set_max_fragments()
+    size_t _dropped_fragments = 0;  //因为片段数达到上限而丢掉的片段数
+
+    //windowed模式:不用_segments,而是把数据直接拷贝进一个预先分配好的环形窗口,
+    //下标为index & _mask;_filled是对应的占用位图,每个bit表示窗口里的一个字节是否已经收到
+    bool _windowed;
+    std::vector<char> _window = {};
+    std::vector<uint64_t> _filled = {};
+    size_t _mask = 0;
+
+    size_t _unassembled = 0;       //收到了但还没有写入_output的字节数
     size_t _should_write_idx = 0;  //当前应该写入的第一个字节
     size_t _capacity;              //!< The maximum number of bytes
     ByteStream _output;            //!< The reassembled in-order byte stream
     bool _have_eof = false;
     size_t _eof_pos = -1;
+
+    size_t _pushes = 0;           //push_substring被调用的次数
+    size_t _in_order_pushes = 0;  //其中走了快速路径(直接写入_output)的次数
+
+    //判断[begin, end)能不能走快速路径,同时更新上面两个计数
+    bool in_order(const uint64_t begin, const uint64_t end);
+
+    //记录eof,并返回[index, index + len)中落在可接收范围内的部分[begin, end)
+    std::pair<uint64_t, uint64_t> accept(const uint64_t index, const size_t len, const bool eof);
+
+    //把data(首字节下标为index)中[begin, end)这段还没有被存下的部分放进_segments
+    void store(const Buffer &data, const uint64_t index, uint64_t begin, const uint64_t end);
     void doWrite();
 
+    //windowed模式下把窗口扩大到能放下capacity个字节,乱序数据搬到新的位置
+    void grow_window(const size_t capacity);
+
+    //windowed模式下的store和doWrite
+    void store_window(const std::string_view data, const uint64_t index, const uint64_t begin, const uint64_t end);
+    void doWrite_window();
+
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    //! \param chunked whether the output ByteStream should hold Buffer chunks (see ByteStream)
+    //! \param windowed whether to reassemble into a preallocated circular window (tracked by an
+    //! occupancy bitmap) instead of keeping each out-of-order piece separately. This allocates a fixed
+    //! amount of memory up front and none per segment.
+    StreamReassembler(const size_t capacity, const bool chunked = false, const bool windowed = false);
 
     //用于得到第一个希望获取的stream index的字符的idx,其值相当于是 unwrap(ackno)-1
     size_t get_should_write_idx() const { return _should_write_idx; }
@@ -54,6 +82,14 @@ class StreamReassembler {
 
     //得到当前的窗口的大小
     size_t get_window_size() const;
+
+    //! The number of bytes that can be held (reassembled and not)
+    size_t capacity() const { return _capacity; }
+
+    //! \brief Change the capacity, e.g. to right-size a receive window
+    //! \note The caller must not shrink it below what has already been accepted: the bytes in the
+    //! output stream plus everything up to the last out-of-order byte. The window engine's memory only grows
+    void set_capacity(const size_t capacity);
     //! \brief Receives a substring and writes any newly contiguous bytes into the stream.
     //!
     //! If accepting all the data would overflow the `capacity` of this
@@ -66,6 +102,13 @@ class StreamReassembler {
     //! \param eof whether or not this segment ends with the end of the stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receives a substring held in a Buffer.
+    //!
+    //! Behaves like the std::string overload, but the bytes that are kept (in the
+    //! output stream in chunked mode, or while waiting to be reassembled) share
+    //! the Buffer's storage instead of being copied.
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -78,6 +121,50 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \name Fast-path statistics
+    //!@{
+
+    //! Number of calls to push_substring()
+    size_t pushes() const { return _pushes; }
+
+    //! Number of pushes whose data was written straight to the output stream because it arrived
+    //! in order while nothing was waiting to be reassembled
+    size_t in_order_pushes() const { return _in_order_pushes; }
+
+    //! Fraction of pushes that took the in-order fast path
+    double fast_path_hit_rate() const { return _pushes ? static_cast<double>(_in_order_pushes) / _pushes : 0; }
+    //!@}
+
+    //! \name Limits on out-of-order data
+    //!@{
+
+    //! \brief Limit how many separate out-of-order fragments are held at once.
+    //!
+    //! Every push walks only the stored fragments it overlaps, so this bounds the work one push
+    //! can do (and the memory spent on bookkeeping) no matter how many tiny, overlapping or duplicate
+    //! segments a peer sends. When a new fragment would exceed the limit, the fragment furthest from
+    //! the next expected byte is discarded (possibly the new one); data that continues the stream is
+    //! always accepted. The window engine keeps no fragments, and its cost per push is bounded by
+    //! the segment length instead.
+    //! \param max_fragments the limit (at least 1)
+    void set_max_fragments(const size_t max_fragments) { _max_fragments = std::max<size_t>(max_fragments, 1); }
+
+    //! Number of out-of-order fragments currently held (always 0 with the window engine)
+    size_t fragments() const { return _segments.size(); }
+
+    //! Number of fragments discarded because of the fragment limit
+    size_t dropped_fragments() const { return _dropped_fragments; }
+    //!@}
+
+    //! \brief Ranges of stream indices held out of order, for reporting them to the peer as SACK blocks
+    //! \details Adjacent pieces are merged. The range containing `recent` (the latest data received)
+    //! comes first, as RFC 2018 asks; the rest are the lowest of the other ranges, in order.
+    //! \param max_ranges the most ranges to return
+    //! \param recent a stream index from the most recently received substring
+    //! \returns `[begin, end)` pairs of stream indices
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges(const size_t max_ranges,
+                                                                  const uint64_t recent) const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
@@ -1,6 +1,10 @@
 #include "tcp_connection.hh"
 
+#include "file_descriptor.hh"
+
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 // Dummy implementation of a TCP connection
 
@@ -37,6 +41,7 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
             return;
         }else{
             //当前的包是合法的,投喂到receiver里,赋值_isn
+            negotiate_options(seg);
             _receiver.segment_received(seg);
             send_segs_in_sender(true);
             return;
@@ -59,7 +64,8 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
             } else {
                 //如果收到的段的ack字段是合法的,并且syn字段为true,我们才可以把它当做正常的包
                 _time_since_last_segment_received = 0;
-                _sender.ack_received(seg.header().ackno, seg.header().win);
+                negotiate_options(seg);
+                _sender.ack_received(seg.header().ackno, peer_window(seg), true, {}, ts_echo(seg));
                 _receiver.segment_received(seg);
                 send_segs_in_sender(true);
                 return;
@@ -67,10 +73,22 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         } else {
             return;
         }
-    }else if(state() == TCPState::State::SYN_RCVD){
+    }
+
+    if (!seg.header().rst && paws_reject(seg)) {
+        //不处理这个段,回一个ack(RFC 7323 5.3 R1);rst不做PAWS检查,交给下面的序号检查
+        send_segs_in_sender(true);
+        return;
+    }
+    if (_ts && seg.header().timestamps.has_value() && seg.header().seqno - _last_ack_sent <= 0) {
+        //只用接在已经确认的数据上的段更新_ts_recent,这样回显的总是最早触发这个ack的段的时间(RFC 7323 4.3)
+        _ts_recent = seg.header().timestamps->first;
+    }
+
+    if (state() == TCPState::State::SYN_RCVD) {
         if(_receiver.segment_received(seg)){
             //如果receiver检测到seg中的seqno是合法的话
-            _sender.ack_received(seg.header().ackno,seg.header().win);
+            _sender.ack_received(seg.header().ackno, peer_window(seg), true, {}, ts_echo(seg));
             check_recv();
             send_segs_in_sender(seg.length_in_sequence_space());
             return;
@@ -81,7 +99,13 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         }
     }
 
-    if (!_sender.ack_received(seg.header().ackno, seg.header().win) && !seg.header().rst) {
+    static const vector<TCPHeader::SackBlock> no_sack{};
+    if (!_sender.ack_received(seg.header().ackno,
+                              peer_window(seg),
+                              seg.length_in_sequence_space() == 0,
+                              _sack ? seg.header().sack : no_sack,
+                              ts_echo(seg)) &&
+        !seg.header().rst) {
         //不知道为什么但是有个测试是测试这个的= =:如果接收方ack了一个发送方还没有发送的字节,
         //那么发送方应该发一个空段.
         send_segs_in_sender(true);
@@ -90,6 +114,8 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 
     _time_since_last_segment_received = 0;
 
+    const optional<WrappingInt32> ackno_before = _receiver.ackno();
+    const size_t unassembled_before = _receiver.unassembled_bytes();
     if (_receiver.segment_received(seg)) {
         //如果该段有一部分是落在了窗口内,我们才能进行rst和keep-alive段的检测
         if (seg.header().rst) {
@@ -108,17 +134,84 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         return;
     }
     check_recv();
+    if (delay_ack(seg, ackno_before, unassembled_before)) {
+        //有数据要发的话照样发出去,顺便带上确认
+        send_segs_in_sender(false);
+        return;
+    }
     send_segs_in_sender(seg.length_in_sequence_space());
 }
 
+bool TCPConnection::delay_ack(const TCPSegment &seg,
+                              const optional<WrappingInt32> ackno_before,
+                              const size_t unassembled_before) {
+    //只推迟按序到达,并且整个被接收的纯数据段的确认.乱序的段,填上空洞的段,syn和fin都要立即确认(RFC 5681 4.2)
+    const size_t len = seg.payload().size();
+    if (!_cfg.delayed_ack || len == 0 || len != seg.length_in_sequence_space() || !ackno_before.has_value() ||
+        seg.header().seqno != ackno_before.value() || unassembled_before ||
+        _receiver.ackno().value() - ackno_before.value() != static_cast<int32_t>(len)) {
+        return false;
+    }
+    if (_quickack) {
+        return false;
+    }
+    if (_quickack_segments > 0) {
+        _quickack_segments--;
+        return false;
+    }
+    //至少每两个段确认一次
+    if (++_segs_unacked >= 2) {
+        return false;
+    }
+    _ack_delay_elapsed = 0;
+    return true;
+}
+
+void TCPConnection::set_quickack(const bool quickack) {
+    _quickack = quickack;
+    if (_quickack && _segs_unacked) {
+        send_segs_in_sender(true);
+    }
+}
+
+optional<uint64_t> TCPConnection::time_until_next_send() const {
+    optional<uint64_t> next = _sender.time_until_next_send();
+    if (_segs_unacked) {
+        const uint64_t ack_due = _cfg.delayed_ack_ms > _ack_delay_elapsed ? _cfg.delayed_ack_ms - _ack_delay_elapsed : 0;
+        next = min(next.value_or(ack_due), ack_due);
+    }
+    return next;
+}
+
 bool TCPConnection::active() const { return _active; }
 
-size_t TCPConnection::write(const string &data) {
-    size_t ret = _sender.stream_in().write(data);
-    send_segs_in_sender();
+size_t TCPConnection::write(const string &data) { return write(data.data(), data.size()); }
+
+//写入的数据被Nagle或者cork留下来的时候,不用为此发一个空的ACK
+size_t TCPConnection::write(const char *data, const size_t len) {
+    size_t ret = _sender.stream_in().write(data, len);
+    send_segs_in_sender(false);
+    return ret;
+}
+
+size_t TCPConnection::write_from(FileDescriptor &fd) {
+    size_t ret = _sender.stream_in().read_from(fd);
+    send_segs_in_sender(false);
     return ret;
 }
 
+void TCPConnection::flush() {
+    _sender.push();
+    send_segs_in_sender(false);
+}
+
+void TCPConnection::set_cork(const bool cork) {
+    _sender.set_cork(cork);
+    if (!cork) {
+        send_segs_in_sender(false);
+    }
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
     if (!_active) {
@@ -133,14 +226,22 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
     }
 
     _sender.tick(ms_since_last_tick);
+    //rtt的精度只有1ms,本地回环上可能测出0
+    _receiver.tick(ms_since_last_tick, _sender.rtt().samples() ? max(_sender.rtt().srtt(), 1.0) : 0);
     if (_sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS) {
         //如果超过了tcp的最大重复发送次数,关闭tcp连接
         force_shutdown(true, _sender.get_seqno());
         return;
     }
     
+    //推迟的确认到时间了就发出去
+    bool ack_due = false;
+    if (_segs_unacked) {
+        _ack_delay_elapsed += ms_since_last_tick;
+        ack_due = _ack_delay_elapsed >= _cfg.delayed_ack_ms;
+    }
     if(state() != TCPState::State::LISTEN){
-        send_segs_in_sender(false);
+        send_segs_in_sender(ack_due);
     }
 }
 
@@ -175,8 +276,9 @@ void TCPConnection::send_segs_in_sender(bool send_empty) {
         if (_receiver.ackno().has_value()) {
             seg.header().ack = true;
             seg.header().ackno = _receiver.ackno().value();
-            seg.header().win = _receiver.window_size();
+            seg.header().win = advertised_window(seg);
         }
+        add_options(seg);
         _segments_out.push(seg);
     }
     return;
@@ -186,12 +288,95 @@ void TCPConnection::send_single_seg(TCPSegment &seg, const WrappingInt32 &seqno)
     if (_receiver.ackno().has_value()) {
         seg.header().ack = true;
         seg.header().ackno = _receiver.ackno().value();
-        seg.header().win = _receiver.window_size();
+        seg.header().win = advertised_window(seg);
     }
     seg.header().seqno = seqno;
+    add_options(seg);
     _segments_out.push(seg);
 }
 
+//能让capacity放进16位窗口字段的最小移位数
+static uint8_t window_scale_for(const size_t capacity) {
+    uint8_t shift = 0;
+    while (shift < TCPHeader::MAX_WINDOW_SCALE && (capacity >> shift) > numeric_limits<uint16_t>::max()) {
+        shift++;
+    }
+    return shift;
+}
+
+void TCPConnection::negotiate_options(const TCPSegment &seg) {
+    _sack = _cfg.sack && seg.header().sack_permitted;
+    //只有双方都带了窗口扩大选项才生效,移位数超过14的按14处理(RFC 7323 2.3)
+    _wscale = _cfg.window_scaling && seg.header().window_scale.has_value();
+    if (_wscale) {
+        _snd_wscale = min(seg.header().window_scale.value(), TCPHeader::MAX_WINDOW_SCALE);
+        _rcv_wscale = window_scale_for(_cfg.recv_capacity);
+    }
+    _ts = _cfg.timestamps && seg.header().timestamps.has_value();
+    if (_ts) {
+        _ts_recent = seg.header().timestamps->first;
+        //之后每个段都带着时间戳,数据段要给它留出位置
+        _sender.set_max_payload(TCPConfig::MAX_PAYLOAD_SIZE - TCPHeader::TIMESTAMPS_LENGTH);
+    }
+}
+
+bool TCPConnection::paws_reject(const TCPSegment &seg) const {
+    if (!_ts || !seg.header().timestamps.has_value() || _time_since_last_segment_received > PAWS_IDLE_MS) {
+        return false;
+    }
+    //按32位回绕比较
+    return static_cast<int32_t>(seg.header().timestamps->first - _ts_recent) < 0;
+}
+
+optional<uint32_t> TCPConnection::ts_echo(const TCPSegment &seg) const {
+    if (!_ts || !seg.header().timestamps.has_value()) {
+        return nullopt;
+    }
+    return seg.header().timestamps->second;
+}
+
+size_t TCPConnection::peer_window(const TCPSegment &seg) const {
+    return seg.header().syn ? seg.header().win : size_t{seg.header().win} << _snd_wscale;
+}
+
+uint16_t TCPConnection::advertised_window(const TCPSegment &seg) const {
+    //窗口右移之后向下取整,通告的窗口只会比实际的小
+    const size_t window = _receiver.window_to_advertise() >> (seg.header().syn ? 0 : _rcv_wscale);
+    return min<size_t>(window, numeric_limits<uint16_t>::max());
+}
+
+void TCPConnection::add_options(TCPSegment &seg) {
+    //主动打开时syn段总是提出SACK,窗口扩大和时间戳;被动打开时只有对方也提出了才回应
+    const bool active_open = !_receiver.ackno().has_value();
+    if (seg.header().syn) {
+        seg.header().sack_permitted = _cfg.sack && (active_open || _sack);
+        if (_cfg.window_scaling && (active_open || _wscale)) {
+            seg.header().window_scale = window_scale_for(_cfg.recv_capacity);
+        }
+    }
+    if (_ts || (seg.header().syn && active_open && _cfg.timestamps)) {
+        //主动打开的syn还没有可以回显的时间戳,TSecr填0
+        seg.header().timestamps = {_sender.timestamp(), _ts_recent};
+    }
+    if (seg.header().ack) {
+        //这个段确认了之前收到的所有数据,推迟的确认不用再发了
+        _last_ack_sent = seg.header().ackno;
+        _segs_unacked = 0;
+        _receiver.window_advertised();
+    }
+    if (!_sack || !_receiver.ackno().has_value() || seg.header().rst) {
+        return;
+    }
+    //选项和载荷加起来不能超过MAX_PAYLOAD_SIZE,否则装不进一个IP/UDP数据报.
+    //SACK选项占4 + 8n字节,所以满载的数据段不带SACK块,纯ack可以带满(同时也不能超过选项区的40字节)
+    const size_t room = min(TCPConfig::MAX_PAYLOAD_SIZE - min(seg.payload().size(), TCPConfig::MAX_PAYLOAD_SIZE),
+                            TCPHeader::MAX_OPTIONS_LENGTH) -
+                        seg.header().options_length();
+    if (room >= 12) {
+        seg.header().sack = _receiver.sack_blocks(min(TCPHeader::MAX_SACK_BLOCKS, (room - 4) / 8));
+    }
+}
+
 void TCPConnection::check_recv() {
     if (!_recv_peer_fin) {
         //如果还没有收到对方的fin,判断这次是否recv到了对方的fin
@@ -6,12 +6,19 @@
 #include "tcp_sender.hh"
 #include "tcp_state.hh"
 
+class FileDescriptor;
+
 //! \brief A complete endpoint of a TCP connection
 class TCPConnection {
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity,
+                          _cfg.chunked_streams,
+                          _cfg.window_reassembler,
+                          _cfg.recv_autotune,
+                          _cfg.recv_capacity_min,
+                          _cfg.sws_avoidance};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -39,6 +46,44 @@ class TCPConnection {
 	bool _recv_peer_fin = false;		//是否收到了对方的eof
 	bool _recv_my_fin_ack = false;		//是否收到了对方对于自己的fin的ack
 
+	bool _sack = false;		//双方都同意使用SACK(RFC 2018),在收到对方的syn时确定
+	//窗口扩大选项(RFC 7323):对方通告的窗口要左移_snd_wscale位,我们通告的窗口要右移_rcv_wscale位.
+	//没有协商成功(_wscale为false)时都是0
+	bool _wscale = false;
+	uint8_t _snd_wscale = 0;
+	uint8_t _rcv_wscale = 0;
+	//时间戳选项(RFC 7323):_ts_recent是要在发出去的段里回显的对方的TSval,
+	//_last_ack_sent是最近发出去的确认号,只有不超过它的段才能更新_ts_recent
+	bool _ts = false;
+	uint32_t _ts_recent = 0;
+	WrappingInt32 _last_ack_sent{0};
+	//连接空闲这么久之后_ts_recent就不可信了,不再用它做PAWS检查(RFC 7323 5.5)
+	static constexpr size_t PAWS_IDLE_MS = 24ul * 24 * 60 * 60 * 1000;
+	//PAWS(RFC 7323 5.3):时间戳比_ts_recent旧的段是序号回绕之前的旧段
+	bool paws_reject(const TCPSegment &seg) const;
+	//收到的段里对方回显的我们的时间戳,用来测量rtt
+	std::optional<uint32_t> ts_echo(const TCPSegment &seg) const;
+	//收到对方的syn时记录协商结果
+	void negotiate_options(const TCPSegment &seg);
+	//给要发出去的段加上选项:syn段带上SACK-permitted和窗口扩大,协商了时间戳之后每个段都带上时间戳,
+	//之后在放得下的时候带上SACK块.同时记下发出去的确认号
+	void add_options(TCPSegment &seg);
+	//收到的段里对方的窗口,以字节为单位
+	size_t peer_window(const TCPSegment &seg) const;
+	//要发出去的段里通告的窗口.syn段里的窗口不做缩放
+	uint16_t advertised_window(const TCPSegment &seg) const;
+	//延迟确认(RFC 1122 4.2.3.2):_segs_unacked是收到了但是还没有确认的数据段的个数,
+	//_ack_delay_elapsed是第一个这样的段到达之后过去的时间.任何带ack的段发出去之后都清零
+	unsigned _segs_unacked = 0;
+	size_t _ack_delay_elapsed = 0;
+	//快速确认模式:_quickack时每个段都立即确认,连接开始时的_quickack_segments个段也是
+	bool _quickack = false;
+	unsigned _quickack_segments = TCPConfig::QUICKACK_SEGMENTS;
+	//收到seg之后能不能先不回ack.ackno_before和unassembled_before是收到seg之前receiver的状态
+	bool delay_ack(const TCPSegment &seg,
+	               const std::optional<WrappingInt32> ackno_before,
+	               const size_t unassembled_before);
+
   public:
     //! \name "Input" interface for the writer
     //!@{
@@ -50,11 +95,25 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write `len` bytes starting at `data` to the outbound byte stream, and send them over TCP if possible
+    //! \returns the number of bytes that were actually written.
+    size_t write(const char *data, const size_t len);
+
+    //! \brief Read data from `fd` directly into the outbound byte stream, and send it over TCP if possible
+    //! \returns the number of bytes read from `fd` (at most remaining_outbound_capacity())
+    size_t write_from(FileDescriptor &fd);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Send everything written so far, even as partial segments that Nagle or the cork would hold back
+    void flush();
+
+    //! \brief Cork or uncork the outbound stream (like TCP_CORK); uncorking sends what was held back
+    void set_cork(const bool cork);
     //!@}
 
     //! \name "Output" interface for the reader
@@ -73,6 +132,8 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief Round-trip time statistics measured by the sender
+    const RTTEstimator &rtt() const { return _sender.rtt(); }
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
@@ -86,6 +147,14 @@ class TCPConnection {
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief Milliseconds until the pacer releases the next segment or a delayed ACK is due, if either is pending
+    //! \note The owner should call tick() no later than that to keep the sending rate and the ACK delay
+    std::optional<uint64_t> time_until_next_send() const;
+
+    //! \brief Turn quick-ACK mode on or off: while it is on, every segment is ACKed at once (see
+    //! TCPConfig::delayed_ack). Turning it on sends an ACK that is being delayed
+    void set_quickack(const bool quickack);
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
@@ -0,0 +1,38 @@
+#include "emulated_link.hh"
+
+using namespace std;
+
+bool EmulatedLink::push(const TCPSegment &seg) {
+    if (_queue.size() >= _queue_limit) {
+        return false;
+    }
+    _queue.emplace_back(_now, seg);
+    return true;
+}
+
+void EmulatedLink::advance(const uint64_t now) {
+    //队列空着的时候不攒额度,否则带宽会在空闲之后一下子变得很大
+    for (; _now < now; ++_now) {
+        _credit = _queue.empty() ? 0 : _credit + _rate;
+        while (not _queue.empty() and (_rate == 0 or _queue.front().second.payload().size() <= _credit)) {
+            _credit -= _rate == 0 ? 0 : _queue.front().second.payload().size();
+            _queued_ms += _now - _queue.front().first;
+            ++_dequeued;
+            _propagating.emplace_back(_now + _delay_ms, move(_queue.front().second));
+            _queue.pop_front();
+        }
+    }
+}
+
+optional<TCPSegment> EmulatedLink::pop() {
+    if (_propagating.empty() or _propagating.front().first > _now) {
+        return {};
+    }
+    TCPSegment seg = move(_propagating.front().second);
+    _propagating.pop_front();
+    return seg;
+}
+
+double EmulatedLink::average_queueing_delay() const {
+    return _dequeued ? static_cast<double>(_queued_ms) / static_cast<double>(_dequeued) : 0;
+}
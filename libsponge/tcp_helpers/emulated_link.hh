@@ -0,0 +1,52 @@
+#ifndef SPONGE_LIBSPONGE_EMULATED_LINK_HH
+#define SPONGE_LIBSPONGE_EMULATED_LINK_HH
+
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+
+//! \brief A one-way bottleneck link, for experiments with congestion control
+//!
+//! Segments wait in a drop-tail queue that drains at a fixed rate, then take a fixed
+//! propagation delay to arrive.
+class EmulatedLink {
+  private:
+    uint64_t _delay_ms;   //单向传播时延
+    size_t _rate;         //瓶颈带宽,每ms可以出队的载荷字节数,0表示不限
+    size_t _queue_limit;  //瓶颈队列最多容纳的segment个数
+    uint64_t _now = 0;    //上一次advance()的时间
+    size_t _credit = 0;   //还没用完的发送额度(字节),攒够了队头的segment才能出队
+    std::deque<std::pair<uint64_t, TCPSegment>> _queue{};        //<进入队列的时间, segment>
+    std::deque<std::pair<uint64_t, TCPSegment>> _propagating{};  //<到达时间, segment>
+    uint64_t _queued_ms = 0;                                     //所有segment在瓶颈队列中等待的总时间
+    uint64_t _dequeued = 0;                                      //出队的segment个数
+
+  public:
+    //! \param[in] delay_ms is the one-way propagation delay
+    //! \param[in] bytes_per_ms is the bottleneck's rate in payload bytes per millisecond, or 0 for no bottleneck
+    //! \param[in] queue_limit is how many segments fit in the bottleneck's queue
+    EmulatedLink(const uint64_t delay_ms, const size_t bytes_per_ms, const size_t queue_limit)
+        : _delay_ms(delay_ms), _rate(bytes_per_ms), _queue_limit(queue_limit) {}
+
+    //! \brief Offer a segment to the link at the current time
+    //! \returns `false` if the bottleneck's queue was full and the segment was dropped
+    bool push(const TCPSegment &seg);
+
+    //! \brief Let time pass until `now` (in milliseconds, on any clock that started with the link)
+    void advance(const uint64_t now);
+
+    //! \brief Take the next segment that has arrived by now, if any
+    std::optional<TCPSegment> pop();
+
+    //! \brief Are there segments in the link that have not arrived yet?
+    bool busy() const { return not _queue.empty() or not _propagating.empty(); }
+
+    //! \brief The average time a segment spent in the bottleneck's queue, in milliseconds
+    double average_queueing_delay() const;
+};
+
+#endif  // SPONGE_LIBSPONGE_EMULATED_LINK_HH
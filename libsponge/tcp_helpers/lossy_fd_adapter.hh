@@ -1,6 +1,7 @@
 #ifndef SPONGE_LIBSPONGE_LOSSY_FD_ADAPTER_HH
 #define SPONGE_LIBSPONGE_LOSSY_FD_ADAPTER_HH
 
+#include "emulated_link.hh"
 #include "file_descriptor.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
@@ -10,7 +11,8 @@
 #include <random>
 #include <utility>
 
-//! An adapter class that adds random dropping behavior to an FD adapter
+//! An adapter class that adds random dropping behavior to an FD adapter,
+//! and optionally delays written segments behind an emulated bottleneck
 template <typename AdapterT>
 class LossyFdAdapter {
   private:
@@ -20,6 +22,19 @@ class LossyFdAdapter {
     //! The underlying FD adapter
     AdapterT _adapter;
 
+    //! Emulated bottleneck that written segments pass through (see FdAdapterConfig::delay_ms_up)
+    std::optional<EmulatedLink> _uplink{};
+
+    //! Total of the tick() arguments, the clock of _uplink
+    uint64_t _now = 0;
+
+    //! Write the segments that have made it through _uplink
+    void _flush_uplink() {
+        while (auto seg = _uplink->pop()) {
+            _adapter.write(seg.value());
+        }
+    }
+
     //! \brief Determine whether or not to drop a given read or write
     //! \param[in] uplink is `true` to use the uplink loss probability, else use the downlink loss probability
     //! \returns `true` if the segment should be dropped
@@ -49,11 +64,21 @@ class LossyFdAdapter {
 
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
     //! \param[in] seg is the packet to either write or drop
+    //! \note With an emulated bottleneck configured, the segment is written by a later tick() instead
     void write(TCPSegment &seg) {
         if (_should_drop(true)) {
             return;
         }
-        return _adapter.write(seg);
+        const auto &cfg = _adapter.config();
+        if (cfg.delay_ms_up == 0 and cfg.rate_up == 0) {
+            return _adapter.write(seg);
+        }
+        if (not _uplink.has_value()) {
+            _uplink.emplace(cfg.delay_ms_up, cfg.rate_up, cfg.queue_up);
+            _uplink->advance(_now);
+        }
+        _uplink->push(seg);
+        _flush_uplink();
     }
 
     //! \name
@@ -65,7 +90,12 @@ class LossyFdAdapter {
     FdAdapterConfig &config_mut() { return _adapter.config_mut(); }      //!< FdAdapterBase::config_mut passthrough
     void tick(const size_t ms_since_last_tick) {
         _adapter.tick(ms_since_last_tick);
-    }  //!< FdAdapterBase::tick passthrough
+        _now += ms_since_last_tick;
+        if (_uplink.has_value()) {
+            _uplink->advance(_now);
+            _flush_uplink();
+        }
+    }  //!< FdAdapterBase::tick passthrough, which also releases segments from the emulated bottleneck
     //!@}
 };
 
@@ -2,6 +2,7 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "congestion_control.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -15,11 +16,67 @@ class TCPConfig {
     static constexpr size_t MAX_PAYLOAD_SIZE = 1452;   //!< Max TCP payload that fits in either IPv4 or UDP datagram
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr uint16_t RTO_MIN_DFLT = 10;       //!< Default lower bound of the adaptive re-transmit timeout
+    static constexpr uint16_t RTO_MAX_DFLT = 60000;    //!< Default upper bound of the adaptive re-transmit timeout
+    static constexpr uint16_t CORK_TIMEOUT_MS = 200;   //!< Longest time a corked partial segment is held back
+    //! Default delay of a delayed ACK: below the default minimum RTO, so the peer does not retransmit a lone
+    //! segment before its ACK leaves
+    static constexpr uint16_t DELAYED_ACK_DFLT = RTO_MIN_DFLT / 2;
+    static constexpr unsigned QUICKACK_SEGMENTS = 16;  //!< Segments ACKed at once at the start of a connection
+    //! Longest interval between zero-window probes, however far the persist timer has backed off
+    static constexpr uint16_t PERSIST_TIMEOUT_MAX_MS = 60000;
+    //! Default smallest receive capacity with auto-tuning: room for two initial windows of the peer
+    static constexpr size_t RECV_CAPACITY_MIN_DFLT = 20 * MAX_PAYLOAD_SIZE;
+    //! Default smallest send capacity with auto-sizing: room for two initial congestion windows
+    static constexpr size_t SEND_CAPACITY_MIN_DFLT = 20 * MAX_PAYLOAD_SIZE;
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
-    size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
-    size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
+    size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes (the upper bound with recv_autotune)
+    size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes (the upper bound with send_autotune)
     std::optional<WrappingInt32> fixed_isn{};
+    bool chunked_streams = false;     //!< Keep stream data as refcounted Buffer chunks instead of copying it
+    bool window_reassembler = false;  //!< Reassemble inbound data in a preallocated window (see StreamReassembler)
+    //! Congestion-control algorithm used by the TCPSender
+    CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::NewReno;
+    //! Compute the re-transmit timeout from measured round-trip times (RFC 6298) instead of always
+    //! restarting from rt_timeout, which then only applies until the first measurement
+    bool adaptive_rto = false;
+    uint16_t rto_min = RTO_MIN_DFLT;  //!< Lower bound of the adaptive re-transmit timeout, in milliseconds
+    uint16_t rto_max = RTO_MAX_DFLT;  //!< Upper bound of the adaptive re-transmit timeout, in milliseconds
+    bool sack = false;                //!< Negotiate selective acknowledgments (RFC 2018)
+    //! Negotiate window scaling (RFC 7323), so that windows (and capacities) can exceed 64 KiB;
+    //! without it, the advertised window is capped at 65535 bytes
+    bool window_scaling = false;
+    //! Negotiate timestamps (RFC 7323): an RTT sample from every ACK, including ACKs of retransmissions,
+    //! and protection against old segments with wrapped sequence numbers (PAWS)
+    bool timestamps = false;
+    //! Pace new segments instead of sending the whole window as one burst: at pacing_rate if it is set,
+    //! otherwise at cwnd / SRTT (twice that in slow start). BBR always paces, at the rate of its model
+    bool pacing = false;
+    uint64_t pacing_rate = 0;  //!< Fixed pacing rate in bytes per second (0: derive it from cwnd and SRTT)
+    //! Nagle's algorithm (RFC 896): hold back a partial segment while earlier data is unacknowledged
+    bool nagle = false;
+    //! Start corked (like TCP_CORK): hold back partial segments until TCPConnection::set_cork(false),
+    //! TCPConnection::flush(), the end of the stream, or CORK_TIMEOUT_MS
+    bool cork = false;
+    //! Delay ACKs of in-order data (RFC 1122 4.2.3.2): ACK every second segment, or delayed_ack_ms after the
+    //! first one. Out-of-order data, data that fills a gap, SYN and FIN are still ACKed at once, and so are
+    //! the first QUICKACK_SEGMENTS segments (to keep the peer's slow start fast)
+    bool delayed_ack = false;
+    uint16_t delayed_ack_ms = DELAYED_ACK_DFLT;  //!< Longest delay of an ACK; keep it below the peer's minimum RTO
+    //! Right-size the receive capacity (and so the advertised window) to how fast the application reads,
+    //! between recv_capacity_min and recv_capacity: bulk flows get large windows, idle ones stay small
+    bool recv_autotune = false;
+    size_t recv_capacity_min = RECV_CAPACITY_MIN_DFLT;  //!< Initial and smallest receive capacity with recv_autotune
+    //! Grow the send capacity with the congestion window, to twice min(cwnd, the peer's window), between
+    //! send_capacity_min and send_capacity: one window in flight and one ready to go
+    bool send_autotune = false;
+    size_t send_capacity_min = SEND_CAPACITY_MIN_DFLT;  //!< Initial and smallest send capacity with send_autotune
+    //! Avoid the silly window syndrome (RFC 1122 4.2.3.3 and 4.2.3.4): the receiver holds the right edge of
+    //! its window back until it can open it by min(half its capacity, MAX_PAYLOAD_SIZE), and the sender
+    //! holds back a segment cut short by the window while data is in flight, unless it is at least half
+    //! the largest window the peer has offered
+    bool sws_avoidance = false;
 };
 
 //! Config for classes derived from FdAdapter
@@ -30,6 +87,13 @@ class FdAdapterConfig {
 
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+
+    //! \name Emulated uplink bottleneck (for LossyFdAdapter; see EmulatedLink)
+    //!@{
+    uint64_t delay_ms_up = 0;  //!< Extra one-way delay for written segments, in milliseconds
+    size_t rate_up = 0;        //!< Bottleneck rate for written segments, in bytes per millisecond (0 for none)
+    size_t queue_up = 1000;    //!< Segments that fit in the bottleneck's queue
+    //!@}
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
@@ -4,6 +4,63 @@
 
 using namespace std;
 
+//选项的kind(RFC 793, RFC 2018, RFC 7323)
+static constexpr uint8_t OPT_EOL = 0;
+static constexpr uint8_t OPT_NOP = 1;
+static constexpr uint8_t OPT_WINDOW_SCALE = 3;
+static constexpr uint8_t OPT_SACK_PERMITTED = 4;
+static constexpr uint8_t OPT_SACK = 5;
+static constexpr uint8_t OPT_TIMESTAMPS = 8;
+
+size_t TCPHeader::options_length() const {
+    //每个选项前面用NOP补齐到4字节
+    return (sack_permitted ? 4 : 0) + (window_scale.has_value() ? 4 : 0) +
+           (timestamps.has_value() ? TIMESTAMPS_LENGTH : 0) + (sack.empty() ? 0 : 4 + 8 * sack.size());
+}
+
+size_t TCPHeader::serialized_length() const { return max<size_t>(4 * doff, LENGTH + options_length()); }
+
+//解析选项部分(一共len字节).认识的选项填进header,不认识的跳过;长度不对的选项说明后面的内容都不可信,直接忽略
+static void parse_options(TCPHeader &header, NetParser &p, size_t len) {
+    while (len > 0 && !p.error()) {
+        const uint8_t kind = p.u8();
+        len--;
+        if (kind == OPT_EOL) {
+            break;
+        }
+        if (kind == OPT_NOP) {
+            continue;
+        }
+        if (len == 0) {
+            break;
+        }
+        const uint8_t opt_len = p.u8();
+        len--;
+        if (opt_len < 2 || opt_len - 2u > len) {
+            break;
+        }
+        size_t body = opt_len - 2u;
+        len -= body;
+        if (kind == OPT_SACK_PERMITTED && body == 0) {
+            header.sack_permitted = true;
+        } else if (kind == OPT_WINDOW_SCALE && body == 1) {
+            header.window_scale = p.u8();
+            body = 0;
+        } else if (kind == OPT_TIMESTAMPS && body == 8) {
+            const uint32_t value = p.u32();
+            header.timestamps = {value, p.u32()};
+            body = 0;
+        } else if (kind == OPT_SACK && body % 8 == 0) {
+            for (; body > 0 && header.sack.size() < TCPHeader::MAX_SACK_BLOCKS; body -= 8) {
+                const WrappingInt32 left{p.u32()};
+                header.sack.emplace_back(left, WrappingInt32{p.u32()});
+            }
+        }
+        p.remove_prefix(body);
+    }
+    p.remove_prefix(len);
+}
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -37,8 +94,11 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    sack_permitted = false;
+    sack.clear();
+    window_scale.reset();
+    timestamps.reset();
+    parse_options(*this, p, doff * 4 - TCPHeader::LENGTH);
 
     if (p.error()) {
         return p.get_error();
@@ -54,14 +114,24 @@ string TCPHeader::serialize() const {
         throw runtime_error("TCP header too short");
     }
 
+    if (sack.size() > MAX_SACK_BLOCKS) {
+        throw runtime_error("too many SACK blocks");
+    }
+    if (options_length() > MAX_OPTIONS_LENGTH) {
+        throw runtime_error("TCP options too long");
+    }
+
+    //doff至少要能放下所有的选项
+    const auto out_doff = static_cast<uint8_t>(serialized_length() / 4);
+
     string ret;
-    ret.reserve(4 * doff);
+    ret.reserve(4 * out_doff);
 
     NetUnparser::u16(ret, sport);              // source port
     NetUnparser::u16(ret, dport);              // destination port
     NetUnparser::u32(ret, seqno.raw_value());  // sequence number
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u8(ret, out_doff << 4);       // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
@@ -72,7 +142,38 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    if (sack_permitted) {
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_SACK_PERMITTED);
+        NetUnparser::u8(ret, 2);
+    }
+    if (window_scale.has_value()) {
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_WINDOW_SCALE);
+        NetUnparser::u8(ret, 3);
+        NetUnparser::u8(ret, window_scale.value());
+    }
+    if (timestamps.has_value()) {
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_TIMESTAMPS);
+        NetUnparser::u8(ret, 10);
+        NetUnparser::u32(ret, timestamps->first);
+        NetUnparser::u32(ret, timestamps->second);
+    }
+    if (not sack.empty()) {
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_NOP);
+        NetUnparser::u8(ret, OPT_SACK);
+        NetUnparser::u8(ret, 2 + 8 * sack.size());
+        for (const auto &[left, right] : sack) {
+            NetUnparser::u32(ret, left.raw_value());
+            NetUnparser::u32(ret, right.raw_value());
+        }
+    }
+
+    ret.resize(4 * out_doff);  // expand header to advertised size (padding with EOL options)
 
     return ret;
 }
@@ -90,13 +191,35 @@ string TCPHeader::to_string() const {
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (sack_permitted) {
+        ss << "TCP option: SACK permitted\n";
+    }
+    if (window_scale.has_value()) {
+        ss << "TCP option: window scale " << +window_scale.value() << '\n';
+    }
+    if (timestamps.has_value()) {
+        ss << "TCP option: timestamps " << dec << timestamps->first << " " << timestamps->second << hex << '\n';
+    }
+    for (const auto &[left, right] : sack) {
+        ss << "TCP option: SACK " << left << "-" << right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (window_scale.has_value()) {
+        ss << ",wscale=" << +window_scale.value();
+    }
+    if (timestamps.has_value()) {
+        ss << ",ts=" << timestamps->first << "/" << timestamps->second;
+    }
+    for (const auto &[left, right] : sack) {
+        ss << ",sack=" << left << "-" << right;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +227,6 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && sack_permitted == other.sack_permitted && sack == other.sack &&
+           window_scale == other.window_scale && timestamps == other.timestamps;
 }
@@ -4,10 +4,25 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <utility>
+#include <vector>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Only the SACK (RFC 2018), window scale and timestamps (RFC 7323) options are understood; other
+//! options are skipped when parsing
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_OPTIONS_LENGTH = 40;  //!< Room for options that `doff` can describe
+    static constexpr size_t MAX_SACK_BLOCKS = 4;      //!< SACK blocks that fit in the options
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;   //!< Largest window scale shift (RFC 7323)
+    static constexpr size_t TIMESTAMPS_LENGTH = 12;   //!< Bytes that the timestamps option takes up
+
+    //! A SACK block: the peer holds the sequence numbers [first, second)
+    using SackBlock = std::pair<WrappingInt32, WrappingInt32>;
+
+    //! Timestamps option: the sender's clock (TSval) and the most recent TSval received from the peer (TSecr)
+    using Timestamps = std::pair<uint32_t, uint32_t>;
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,6 +65,20 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options (serialize() grows `doff` to make room for them)
+    //!@{
+    bool sack_permitted = false;                //!< SACK-permitted option, only sent on SYN segments
+    std::vector<SackBlock> sack{};              //!< SACK blocks, at most MAX_SACK_BLOCKS
+    std::optional<uint8_t> window_scale{};      //!< Window scale shift, only sent on SYN segments
+    std::optional<Timestamps> timestamps{};     //!< TSval and TSecr, in every segment once negotiated
+    //!@}
+
+    //! Bytes that the options above take up in the serialized header (a multiple of 4)
+    size_t options_length() const;
+
+    //! Length of the serialized header: `doff` words, or more if the options need the room
+    size_t serialized_length() const;
+
     //! Parse the TCP fields from the provided NetParser
     //即用一个含有string的buf,生成一个NetParser对象,然后作为本函数的参数,用于给TCPHeader的各个字段赋值
     //相当于解码
@@ -0,0 +1,42 @@
+#include "tcp_memory.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+atomic<size_t> TCPMemory::_allocated{0};
+atomic<size_t> TCPMemory::_limit{0};
+
+bool TCPMemory::under_pressure() {
+    const size_t limit = _limit;
+    return limit != 0 && _allocated > limit;
+}
+
+TCPMemory::Charge &TCPMemory::Charge::operator=(Charge &&other) noexcept {
+    if (this != &other) {
+        resize(0);
+        _bytes = other._bytes;
+        other._bytes = 0;
+    }
+    return *this;
+}
+
+void TCPMemory::Charge::resize(const size_t bytes) {
+    if (bytes > _bytes) {
+        _allocated += bytes - _bytes;
+    } else {
+        _allocated -= _bytes - bytes;
+    }
+    _bytes = bytes;
+}
+
+size_t TCPMemory::Charge::affordable(const size_t bytes) const {
+    const size_t limit = _limit;
+    if (bytes <= _bytes || limit == 0) {
+        return bytes;
+    }
+    const size_t allocated = _allocated;
+    //预算已经用完时保持现在的大小
+    const size_t room = allocated < limit ? limit - allocated : 0;
+    return min(bytes, _bytes + room);
+}
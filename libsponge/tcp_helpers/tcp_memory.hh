@@ -0,0 +1,57 @@
+#ifndef SPONGE_LIBSPONGE_TCP_MEMORY_HH
+#define SPONGE_LIBSPONGE_TCP_MEMORY_HH
+
+#include <atomic>
+#include <cstddef>
+
+//! \brief A process-wide budget for the stream buffers of all TCP connections (like Linux's tcp_mem)
+//!
+//! Every TCPSender and TCPReceiver charges the capacity of its stream here. Auto-sized buffers
+//! (TCPConfig::send_autotune and recv_autotune) only grow within the budget, and shrink back toward
+//! their minimum while the total is over it. Fixed capacities and minimum sizes are always granted,
+//! so the total can exceed the budget; that is what puts the auto-sized buffers under pressure.
+class TCPMemory {
+  private:
+    static std::atomic<size_t> _allocated;
+    static std::atomic<size_t> _limit;
+
+  public:
+    //! \brief Set the budget in bytes (0, the default, for none)
+    static void set_limit(const size_t bytes) { _limit = bytes; }
+
+    //! \brief The budget in bytes (0 for none)
+    static size_t limit() { return _limit; }
+
+    //! \brief Bytes charged by all connections
+    static size_t allocated() { return _allocated; }
+
+    //! \brief Is more charged than the budget allows? Auto-sized buffers then shrink to their minimum
+    static bool under_pressure();
+
+    //! \brief The bytes charged for one buffer, given back when it is destroyed
+    class Charge {
+      private:
+        size_t _bytes = 0;
+
+      public:
+        Charge() = default;
+        explicit Charge(const size_t bytes) { resize(bytes); }
+        ~Charge() { resize(0); }
+        Charge(Charge &&other) noexcept : _bytes(other._bytes) { other._bytes = 0; }
+        Charge &operator=(Charge &&other) noexcept;
+        Charge(const Charge &) = delete;
+        Charge &operator=(const Charge &) = delete;
+
+        //! \brief The bytes charged
+        size_t bytes() const { return _bytes; }
+
+        //! \brief Charge `bytes` instead (always granted)
+        void resize(const size_t bytes);
+
+        //! \brief How much of a growth to `bytes` the budget allows (a smaller `bytes` is returned as is)
+        //! \note Connections on other threads may grow at the same time, so the budget is a soft limit
+        size_t affordable(const size_t bytes) const;
+    };
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_MEMORY_HH
@@ -5,6 +5,7 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
@@ -25,7 +26,14 @@ template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        //打开了pacing时,下一个段可以发送的时间可能比一个tick更早,到时候就要醒来
+        size_t timeout = TCP_TICK_MS;
+        if (_tcp.has_value()) {
+            if (const auto next_send = _tcp.value().time_until_next_send(); next_send.has_value()) {
+                timeout = min<size_t>(timeout, next_send.value());
+            }
+        }
+        auto ret = _eventloop.wait_next_event(timeout);
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
@@ -36,6 +44,11 @@ void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
             _datagram_adapter.tick(next_time - base_time);
             base_time = next_time;
         }
+
+        // with the shared rings there is no fd event for newly reassembled bytes, so check after every event
+        if (_outbound_ring) {
+            _pump_shared_rings();
+        }
     }
 }
 
@@ -82,7 +95,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                             }
 
                             // debugging output:
-                            if (_thread_data.eof() and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
+                            if (_outbound_shutdown and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
                                 cerr << "DEBUG: Outbound stream to "
                                      << _datagram_adapter.config().destination.to_string()
                                      << " has been fully acknowledged.\n";
@@ -91,64 +104,69 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                         },
                         [&] { return _tcp->active(); });
 
-    // rule 2: read from pipe into outbound buffer
-    _eventloop.add_rule(
-        _thread_data,
-        Direction::In,
-        [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
-            const auto len = data.size();
-            const auto amount_written = _tcp->write(move(data));
-            if (amount_written != len) {
-                throw runtime_error("TCPConnection::write() accepted less than advertised length");
-            }
-
-            if (_thread_data.eof()) {
+    if (_outbound_ring) {
+        // rules 2 and 3 with the shared rings: the owner signals _tcp_wakeup whenever it
+        // writes to the outbound ring or makes room in the inbound ring
+        _eventloop.add_rule(*_tcp_wakeup,
+                            Direction::In,
+                            [&] {
+                                _tcp_wakeup->wait();
+                                _pump_shared_rings();
+                            },
+                            [&] { return _tcp->active() or not _inbound_shutdown; });
+    } else {
+        // rule 2: read from pipe into outbound buffer
+        _eventloop.add_rule(
+            _thread_data,
+            Direction::In,
+            [&] {
+                // The bytes go from the socket straight into the outbound stream's storage.
+                _tcp->write_from(_thread_data);
+
+                if (_thread_data.eof()) {
+                    _tcp->end_input_stream();
+                    _outbound_shutdown = true;
+
+                    // debugging output:
+                    cerr << "DEBUG: Outbound stream to " << _datagram_adapter.config().destination.to_string()
+                         << " finished (" << _tcp.value().bytes_in_flight() << " byte"
+                         << (_tcp.value().bytes_in_flight() == 1 ? "" : "s") << " still in flight).\n";
+                }
+            },
+            [&] { return (_tcp->active()) and (not _outbound_shutdown) and (_tcp->remaining_outbound_capacity() > 0); },
+            [&] {
                 _tcp->end_input_stream();
                 _outbound_shutdown = true;
-
-                // debugging output:
-                cerr << "DEBUG: Outbound stream to " << _datagram_adapter.config().destination.to_string()
-                     << " finished (" << _tcp.value().bytes_in_flight() << " byte"
-                     << (_tcp.value().bytes_in_flight() == 1 ? "" : "s") << " still in flight).\n";
-            }
-        },
-        [&] { return (_tcp->active()) and (not _outbound_shutdown) and (_tcp->remaining_outbound_capacity() > 0); },
-        [&] {
-            _tcp->end_input_stream();
-            _outbound_shutdown = true;
-        });
-
-    // rule 3: read from inbound buffer into pipe
-    _eventloop.add_rule(
-        _thread_data,
-        Direction::Out,
-        [&] {
-            ByteStream &inbound = _tcp->inbound_stream();
-            // Write from the inbound_stream into
-            // the pipe, handling the possibility of a partial
-            // write (i.e., only pop what was actually written).
-            const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
-            inbound.pop_output(bytes_written);
-
-            if (inbound.eof() or inbound.error()) {
-                _thread_data.shutdown(SHUT_WR);
-                _inbound_shutdown = true;
-
-                // debugging output:
-                cerr << "DEBUG: Inbound stream from " << _datagram_adapter.config().destination.to_string()
-                     << " finished " << (inbound.error() ? "with an error/reset.\n" : "cleanly.\n");
-                if (_tcp.value().state() == TCPState::State::TIME_WAIT) {
-                    cerr << "DEBUG: Waiting for lingering segments (e.g. retransmissions of FIN) from peer...\n";
+            });
+
+        // rule 3: read from inbound buffer into pipe
+        _eventloop.add_rule(
+            _thread_data,
+            Direction::Out,
+            [&] {
+                ByteStream &inbound = _tcp->inbound_stream();
+                // Write from the inbound_stream into
+                // the pipe, handling the possibility of a partial
+                // write (i.e., only pop what was actually written).
+                inbound.write_to(_thread_data, 65536);
+
+                if (inbound.eof() or inbound.error()) {
+                    _thread_data.shutdown(SHUT_WR);
+                    _inbound_shutdown = true;
+
+                    // debugging output:
+                    cerr << "DEBUG: Inbound stream from " << _datagram_adapter.config().destination.to_string()
+                         << " finished " << (inbound.error() ? "with an error/reset.\n" : "cleanly.\n");
+                    if (_tcp.value().state() == TCPState::State::TIME_WAIT) {
+                        cerr << "DEBUG: Waiting for lingering segments (e.g. retransmissions of FIN) from peer...\n";
+                    }
                 }
-            }
-        },
-        [&] {
-            return (not _tcp->inbound_stream().buffer_empty()) or
-                   ((_tcp->inbound_stream().eof() or _tcp->inbound_stream().error()) and not _inbound_shutdown);
-        });
+            },
+            [&] {
+                return (not _tcp->inbound_stream().buffer_empty()) or
+                       ((_tcp->inbound_stream().eof() or _tcp->inbound_stream().error()) and not _inbound_shutdown);
+            });
+    }
 
     // rule 4: read outbound segments from TCPConnection and send as datagrams
     _eventloop.add_rule(_datagram_adapter,
@@ -162,6 +180,65 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                         [&] { return not _tcp->segments_out().empty(); });
 }
 
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_pump_shared_rings() {
+    bool outbound_progress = false;
+    bool inbound_progress = false;
+
+    // outbound: same job as rule 2, reading from the ring instead of the pipe
+    while (_tcp->active() and not _outbound_shutdown and _tcp->remaining_outbound_capacity() > 0) {
+        const auto data = _outbound_ring->peek();
+        if (data.empty()) {
+            break;
+        }
+        _outbound_ring->pop(_tcp->write(data.data(), min(data.size(), _tcp->remaining_outbound_capacity())));
+        outbound_progress = true;
+    }
+
+    if (_tcp->active() and not _outbound_shutdown and _outbound_ring->eof()) {
+        _tcp->end_input_stream();
+        _outbound_shutdown = true;
+
+        // debugging output:
+        cerr << "DEBUG: Outbound stream to " << _datagram_adapter.config().destination.to_string()
+             << " finished (" << _tcp.value().bytes_in_flight() << " byte"
+             << (_tcp.value().bytes_in_flight() == 1 ? "" : "s") << " still in flight).\n";
+    }
+
+    // inbound: same job as rule 3, writing into the ring instead of the pipe
+    ByteStream &inbound = _tcp->inbound_stream();
+    if (_inbound_ring->output_ended()) {
+        // the owner has stopped reading, so nothing will ever drain the ring
+        inbound.pop_output(inbound.buffer_size());
+    }
+
+    if (not inbound.buffer_empty() and _inbound_ring->remaining_capacity() > 0) {
+        size_t bytes_written = 0;
+        for (const auto &iov : inbound.peek_buffers(_inbound_ring->remaining_capacity()).as_iovecs()) {
+            bytes_written += _inbound_ring->write({static_cast<const char *>(iov.iov_base), iov.iov_len});
+        }
+        inbound.pop_output(bytes_written);
+        inbound_progress = true;
+    }
+
+    if ((inbound.eof() or inbound.error()) and not _inbound_shutdown) {
+        _inbound_ring->end_input();
+        _inbound_shutdown = true;
+        inbound_progress = true;
+
+        // debugging output:
+        cerr << "DEBUG: Inbound stream from " << _datagram_adapter.config().destination.to_string()
+             << " finished " << (inbound.error() ? "with an error/reset.\n" : "cleanly.\n");
+    }
+
+    if (outbound_progress) {
+        _outbound_wakeup->notify();
+    }
+    if (inbound_progress) {
+        _inbound_wakeup->notify();
+    }
+}
+
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
 //! \param[in] type is the type of AF_UNIX sockets to create (e.g., SOCK_SEQPACKET)
 //! \returns a std::pair of connected sockets
@@ -193,6 +270,10 @@ TCPSpongeSocket<AdaptT>::~TCPSpongeSocket() {
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::wait_until_closed() {
     shutdown(SHUT_RDWR);
+    if (_outbound_ring) {
+        _inbound_ring->end_output();
+        ring_end_input();
+    }
     if (_tcp_thread.joinable()) {
         cerr << "DEBUG: Waiting for clean shutdown... ";
         _tcp_thread.join();
@@ -259,10 +340,22 @@ void TCPSpongeSocket<AdaptT>::_tcp_main() {
         }
         _tcp_loop([] { return true; });
         shutdown(SHUT_RDWR);
+        if (_outbound_ring) {
+            // make sure an owner blocked in ring_read() or ring_write() wakes up and sees the end
+            _inbound_ring->end_input();
+            _outbound_ring->end_output();
+            _inbound_wakeup->notify();
+            _outbound_wakeup->notify();
+        }
         if (not _tcp.value().active()) {
             cerr << "DEBUG: TCP connection finished "
                  << (_tcp.value().state() == TCPState::State::RESET ? "uncleanly" : "cleanly.\n");
         }
+        if (const auto &rtt = _tcp.value().rtt(); rtt.samples() > 0) {
+            cerr << "DEBUG: RTT over " << rtt.samples() << " sample" << (rtt.samples() == 1 ? "" : "s")
+                 << ": min " << rtt.min() << " ms, max " << rtt.max() << " ms, smoothed " << rtt.srtt()
+                 << " ms (variation " << rtt.rttvar() << " ms).\n";
+        }
         _tcp.reset();
     } catch (const exception &e) {
         cerr << "Exception in TCPConnection runner thread: " << e.what() << "\n";
@@ -270,6 +363,88 @@ void TCPSpongeSocket<AdaptT>::_tcp_main() {
     }
 }
 
+//! \param[in] capacity is the size of each of the two rings, in bytes
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::enable_shared_ring(const size_t capacity) {
+    if (_tcp) {
+        throw runtime_error("enable_shared_ring() with TCPConnection already initialized");
+    }
+
+    _outbound_ring = make_unique<SharedByteRing>(capacity);
+    _inbound_ring = make_unique<SharedByteRing>(capacity);
+    _tcp_wakeup.emplace();
+    _inbound_wakeup.emplace();
+    _outbound_wakeup.emplace();
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_check_shared_ring(const char *caller) const {
+    if (not _outbound_ring) {
+        throw runtime_error(string(caller) + "() without enable_shared_ring()");
+    }
+}
+
+//! \param[in] data is the string to write
+//! \param[in] write_all is whether to wait until all of `data` has been accepted
+template <typename AdaptT>
+size_t TCPSpongeSocket<AdaptT>::ring_write(string_view data, const bool write_all) {
+    _check_shared_ring("ring_write");
+    size_t total_bytes_written = 0;
+    while (true) {
+        const size_t bytes_written = _outbound_ring->write(data.substr(total_bytes_written));
+        total_bytes_written += bytes_written;
+        if (bytes_written) {
+            _tcp_wakeup->notify();
+        }
+
+        if (not write_all or total_bytes_written == data.size() or _outbound_ring->output_ended()) {
+            return total_bytes_written;
+        }
+        _outbound_wakeup->wait();
+    }
+}
+
+//! \param[in] limit is the maximum number of bytes to read
+template <typename AdaptT>
+string TCPSpongeSocket<AdaptT>::ring_read(const size_t limit) {
+    _check_shared_ring("ring_read");
+    string ret;
+    while (true) {
+        // the readable bytes may wrap around the end of the ring, so peek until it is empty
+        while (ret.size() < limit) {
+            const auto data = _inbound_ring->peek();
+            if (data.empty()) {
+                break;
+            }
+            const size_t len = min(data.size(), limit - ret.size());
+            ret.append(data.data(), len);
+            _inbound_ring->pop(len);
+        }
+
+        if (not ret.empty()) {
+            _tcp_wakeup->notify();
+            return ret;
+        }
+        if (limit == 0 or _inbound_ring->eof()) {
+            return ret;
+        }
+        _inbound_wakeup->wait();
+    }
+}
+
+template <typename AdaptT>
+bool TCPSpongeSocket<AdaptT>::ring_eof() const {
+    _check_shared_ring("ring_eof");
+    return _inbound_ring->eof();
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::ring_end_input() {
+    _check_shared_ring("ring_end_input");
+    _outbound_ring->end_input();
+    _tcp_wakeup->notify();
+}
+
 //! Specialization of TCPSpongeSocket for TCPOverUDPSocketAdapter
 template class TCPSpongeSocket<TCPOverUDPSocketAdapter>;
 
@@ -290,6 +465,12 @@ CS144TCPSocket::CS144TCPSocket() : TCPOverIPv4SpongeSocket(TCPOverIPv4OverTunFdA
 void CS144TCPSocket::connect(const Address &address) {
     TCPConfig tcp_config;
     tcp_config.rt_timeout = 100;
+    tcp_config.adaptive_rto = true;
+    tcp_config.sack = true;
+    tcp_config.window_scaling = true;
+    tcp_config.timestamps = true;
+    tcp_config.nagle = true;
+    tcp_config.sws_avoidance = true;
 
     FdAdapterConfig multiplexer_config;
     multiplexer_config.source = {"169.254.144.9", to_string(uint16_t(random_device()()))};
@@ -321,6 +502,12 @@ FullStackSocket::FullStackSocket()
 void FullStackSocket::connect(const Address &address) {
     TCPConfig tcp_config;
     tcp_config.rt_timeout = 100;
+    tcp_config.adaptive_rto = true;
+    tcp_config.sack = true;
+    tcp_config.window_scaling = true;
+    tcp_config.timestamps = true;
+    tcp_config.nagle = true;
+    tcp_config.sws_avoidance = true;
 
     FdAdapterConfig multiplexer_config;
     multiplexer_config.source = {LOCAL_TAP_IP_ADDRESS, to_string(uint16_t(random_device()()))};
@@ -2,17 +2,22 @@
 #define SPONGE_LIBSPONGE_TCP_SPONGE_SOCKET_HH
 
 #include "byte_stream.hh"
+#include "eventfd.hh"
 #include "eventloop.hh"
 #include "fd_adapter.hh"
 #include "file_descriptor.hh"
 #include "network_interface.hh"
+#include "shared_byte_ring.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
 #include <cstdint>
+#include <limits>
+#include <memory>
 #include <optional>
+#include <string_view>
 #include <thread>
 #include <vector>
 
@@ -23,6 +28,21 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Stream socket for reads and writes between owner and TCP thread
     LocalStreamSocket _thread_data;
 
+    //! \name Shared-ring data path, used instead of _thread_data after enable_shared_ring()
+    //!@{
+    std::unique_ptr<SharedByteRing> _outbound_ring{};  //!< Bytes written by the owner, read by the TCP thread
+    std::unique_ptr<SharedByteRing> _inbound_ring{};   //!< Bytes written by the TCP thread, read by the owner
+    std::optional<EventFD> _tcp_wakeup{};       //!< Signalled by the owner after it writes to or reads from a ring
+    std::optional<EventFD> _inbound_wakeup{};   //!< Signalled by the TCP thread after it fills the inbound ring
+    std::optional<EventFD> _outbound_wakeup{};  //!< Signalled by the TCP thread after it drains the outbound ring
+    //!@}
+
+    //! Move bytes between the shared rings and the TCPConnection (TCP thread only)
+    void _pump_shared_rings();
+
+    //! Throw unless enable_shared_ring() has been called
+    void _check_shared_ring(const char *caller) const;
+
     //! Adapter to underlying datagram socket (e.g., UDP or IP)
     AdaptT _datagram_adapter;
 
@@ -70,6 +90,30 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
     void listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
+    //! \name Shared-ring data path
+    //! After enable_shared_ring(), the owner exchanges data with the TCP thread through a pair of
+    //! lock-free rings instead of reading and writing this socket, avoiding two syscalls and a kernel
+    //! copy per chunk in each direction. As with a socket, one owner thread may read while another writes.
+    //!@{
+
+    //! Switch to the shared-ring data path; must be called before connect() or listen_and_accept()
+    void enable_shared_ring(const size_t capacity = TCPConfig::DEFAULT_CAPACITY);
+
+    //! Write `data` to the outbound stream, blocking (if `write_all`) until all of it is accepted
+    //! \returns the number of bytes accepted (less than requested only if the connection has finished)
+    size_t ring_write(std::string_view data, const bool write_all = true);
+
+    //! Read up to `limit` bytes of the inbound stream, blocking until at least one byte is available
+    //! \returns the bytes read, or an empty string once the inbound stream has ended
+    std::string ring_read(const size_t limit = std::numeric_limits<size_t>::max());
+
+    //! \returns `true` once the inbound stream has ended and every byte has been read
+    bool ring_eof() const;
+
+    //! End the outbound stream (the shared-ring equivalent of shutdown(SHUT_WR))
+    void ring_end_input();
+    //!@}
+
     //! When a connected socket is destructed, it will send a RST
     ~TCPSpongeSocket();
 
@@ -42,7 +42,8 @@ bool TCPReceiver::segment_received(const TCPSegment &seg) {
             //比如lab2.pdf中的图"cat"中的c的stream_index实际上比absolute seqno小1
             size_t stream_index_right = seg.payload().size()==0 ? stream_index:stream_index + seg.payload().size()-1;
             if (in_window(stream_index,stream_index_right)) {
-                _reassembler.push_substring(seg.payload().copy(), stream_index, seg.header().fin);
+                _last_segment_index = stream_index;
+                _reassembler.push_substring(seg.payload(), stream_index, seg.header().fin);
                 return true;
             } else {
                 return false;
@@ -50,7 +51,8 @@ bool TCPReceiver::segment_received(const TCPSegment &seg) {
         } else {
             //对于SYN=1的包来说,其stream_index为0
             stream_index++;
-            _reassembler.push_substring(seg.payload().copy(), stream_index, seg.header().fin);
+            _last_segment_index = stream_index;
+            _reassembler.push_substring(seg.payload(), stream_index, seg.header().fin);
             return true;
         }
     }
@@ -78,3 +80,63 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
 }
 
 size_t TCPReceiver::window_size() const { return _reassembler.get_window_size(); }
+
+size_t TCPReceiver::window_to_advertise() const {
+    //窗口的右边界是get_should_write_idx() + window_size(),也就是应用读走的字节数加上容量
+    const size_t left = stream_out().bytes_written();
+    const size_t window = window_size();
+    if (!_sws_avoidance || left + window >= _advertised_edge + min(capacity() / 2, TCPConfig::MAX_PAYLOAD_SIZE)) {
+        return window;
+    }
+    //右边界不往回退,剩下的窗口可能是0
+    return _advertised_edge > left ? _advertised_edge - left : 0;
+}
+
+void TCPReceiver::window_advertised() {
+    _advertised_edge = max(_advertised_edge, stream_out().bytes_written() + window_to_advertise());
+}
+
+void TCPReceiver::tick(const size_t ms_since_last_tick, const double rtt_ms) {
+    if (!_autotune || rtt_ms <= 0) {
+        return;
+    }
+    _measure_elapsed += ms_since_last_tick;
+    if (static_cast<double>(_measure_elapsed) < rtt_ms) {
+        return;
+    }
+    const size_t read = stream_out().bytes_read();
+    const size_t copied = read - _measure_start;
+    _measure_start = read;
+    _measure_elapsed = 0;
+
+    const size_t current = capacity();
+    //发送方每个rtt最多把窗口翻倍,所以要留两倍的余量;再加上AUTOTUNE_HEADROOM,否则受窗口限制的发送方
+    //每个rtt只能发来半个容量(另一半还在缓冲区里等应用读),copied永远到不了容量的一半,窗口就长不起来.
+    //超出了进程的内存预算时往最小的容量缩,扩大时也只能用预算剩下的部分
+    size_t target = TCPMemory::under_pressure() ? _min_capacity
+                                                : clamp(2 * copied + AUTOTUNE_HEADROOM, _min_capacity, _capacity);
+    if (target > current) {
+        target = _memory.affordable(target);
+    } else if (target < current) {
+        if (unassembled_bytes()) {
+            return;
+        }
+        target = max({target, current / 2, _advertised_edge > read ? _advertised_edge - read : 0});
+    }
+    if (target != current) {
+        _reassembler.set_capacity(target);
+        _memory.resize(capacity());
+    }
+}
+
+vector<TCPHeader::SackBlock> TCPReceiver::sack_blocks(const size_t max_blocks) const {
+    vector<TCPHeader::SackBlock> blocks;
+    if (!_isn_legal) {
+        return blocks;
+    }
+    //stream index转成序号:absolute seqno = stream index + 1
+    for (const auto &[begin, end] : _reassembler.unassembled_ranges(max_blocks, _last_segment_index)) {
+        blocks.emplace_back(wrap(begin + 1, _isn), wrap(end + 1, _isn));
+    }
+    return blocks;
+}
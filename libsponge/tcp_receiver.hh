@@ -3,10 +3,14 @@
 
 #include "byte_stream.hh"
 #include "stream_reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_memory.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -25,12 +29,42 @@ class TCPReceiver {
 	WrappingInt32 _isn = WrappingInt32(0);		//tcp报文的isn,只有当_isn_legal==true的时候才有效
 	bool in_window(const size_t&,const size_t&)const;
 	size_t get_checkpoint()const{return _reassembler.get_should_write_idx();}
+	size_t _last_segment_index = 0;	//最近收到的段的第一个字节的stream index,用于把它所在的SACK块放在最前面
+
+	//接收窗口的自动调整:每过一个rtt看应用读走了多少数据,让容量在[_min_capacity, _capacity]之间跟着变化.
+	//_advertised_edge是通告过的最大的窗口右边界(stream index),缩小容量的时候不能让窗口的右边界往回退
+	bool _autotune;
+	size_t _min_capacity;
+	size_t _advertised_edge = 0;
+	size_t _measure_start = 0;	//这一轮测量开始时应用已经读走的字节数
+	size_t _measure_elapsed = 0;	//这一轮测量已经过去的时间
+	static constexpr size_t AUTOTUNE_HEADROOM = 16 * TCPConfig::MAX_PAYLOAD_SIZE;
+	TCPMemory::Charge _memory;	//在进程的内存预算(TCPMemory)中记下的容量
+
+	//避免糊涂窗口综合症:窗口的右边界能向右移动至少min(容量的一半, MSS)之前,通告的窗口保持原来的右边界
+	bool _sws_avoidance;
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity) {}
+    //! \param chunked whether the inbound ByteStream should keep payload Buffers without copying them
+    //! \param windowed whether the StreamReassembler should use its preallocated window engine
+    //! \param autotune whether to right-size the capacity to how fast the application reads (see tick())
+    //! \param min_capacity with `autotune`, the capacity to start with and never to go below
+    //! \param sws_avoidance whether to hold back small window updates (see window_to_advertise())
+    TCPReceiver(const size_t capacity,
+                const bool chunked = false,
+                const bool windowed = false,
+                const bool autotune = false,
+                const size_t min_capacity = 0,
+                const bool sws_avoidance = false)
+        : _reassembler(autotune ? std::min(min_capacity, capacity) : capacity, chunked, windowed)
+        , _capacity(capacity)
+        , _autotune(autotune)
+        , _min_capacity(std::min(min_capacity, capacity))
+        , _memory(_reassembler.capacity())
+        , _sws_avoidance(sws_avoidance) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -55,9 +89,36 @@ class TCPReceiver {
     size_t window_size() const;
     //!@}
 
+    //! \brief SACK blocks (RFC 2018) describing the out-of-order data held by the receiver
+    //! \details The block holding the most recently received segment comes first.
+    //! \returns empty if no SYN has been received or nothing is out of order
+    std::vector<TCPHeader::SackBlock> sack_blocks(const size_t max_blocks) const;
+
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
+    //! \brief The current capacity (with auto-tuning, somewhere between the configured bounds)
+    size_t capacity() const { return _reassembler.capacity(); }
+
+    //! \brief The window to advertise to the peer: window_size(), or with SWS avoidance (RFC 1122 4.2.3.3)
+    //! what is left of the last advertised window, until the right edge can move by min(half the capacity,
+    //! one MSS)
+    size_t window_to_advertise() const;
+
+    //! \brief Record that window_to_advertise() was advertised to the peer; auto-tuning never pulls
+    //! the right edge of an advertised window back
+    void window_advertised();
+
+    //! \brief Notify the TCPReceiver of the passage of time, for auto-tuning
+    //! \details Once per round trip, the capacity becomes twice what the application read during it
+    //! (the sender may double its window each round trip) plus 16 segments of headroom, within the
+    //! configured bounds. It shrinks
+    //! by at most half per round trip, and not while data is missing (loss makes reads look slow).
+    //! It only grows within the process's TCPMemory budget, and heads for the lower bound while the
+    //! budget is exceeded.
+    //! \param rtt_ms the connection's smoothed round-trip time (0 if it has not been measured yet)
+    void tick(const size_t ms_since_last_tick, const double rtt_ms);
+
     //! \brief handle an inbound segment
     //! \returns `true` if any part of the segment was inside the window
     bool segment_received(const TCPSegment &seg);
@@ -2,7 +2,9 @@
 
 #include "tcp_config.hh"
 
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <random>
 // Dummy implementation of a TCP sender
 
@@ -14,14 +16,58 @@ void DUMMY_CODE(Targs &&.../* unused */) {}
 
 using namespace std;
 
+//lab中的发送方只有这三个参数,其他选项都保持TCPConfig的默认值
+static TCPConfig lab_config(const size_t capacity,
+                            const uint16_t retx_timeout,
+                            const optional<WrappingInt32> fixed_isn) {
+    TCPConfig cfg;
+    cfg.send_capacity = capacity;
+    cfg.rt_timeout = retx_timeout;
+    cfg.fixed_isn = fixed_isn;
+    return cfg;
+}
+
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
 TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
-    : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
-    , _initial_retransmission_timeout{retx_timeout}
-    , _stream(capacity)
-    , _rto(_initial_retransmission_timeout) {}
+    : TCPSender(lab_config(capacity, retx_timeout, fixed_isn)) {}
+
+//! \param[in] cfg the connection's configuration. The sender uses send_capacity, rt_timeout, fixed_isn,
+//! chunked_streams, congestion_control, adaptive_rto, rto_min, rto_max, pacing, pacing_rate, nagle, cork,
+//! send_autotune, send_capacity_min and sws_avoidance
+TCPSender::TCPSender(const TCPConfig &cfg)
+    : _isn(cfg.fixed_isn.value_or(WrappingInt32{random_device()()}))
+    , _initial_retransmission_timeout{cfg.rt_timeout}
+    , _stream(cfg.send_autotune ? min(cfg.send_capacity_min, cfg.send_capacity) : cfg.send_capacity,
+              cfg.chunked_streams)
+    , _rto(_initial_retransmission_timeout)
+    , _adaptive_rto(cfg.adaptive_rto)
+    , _rto_min(cfg.rto_min)
+    , _rto_max(max(cfg.rto_min, cfg.rto_max))
+    , _congestion_control(CongestionControl::make(cfg.congestion_control, TCPConfig::MAX_PAYLOAD_SIZE))
+    , _pacing(cfg.pacing)
+    , _fixed_pacing_rate(static_cast<double>(cfg.pacing_rate) / 1000)
+    , _nagle(cfg.nagle)
+    , _cork(cfg.cork)
+    , _autotune(cfg.send_autotune)
+    , _min_capacity(min(cfg.send_capacity_min, cfg.send_capacity))
+    , _max_capacity(cfg.send_capacity)
+    , _memory(_stream.capacity())
+    , _sws_avoidance(cfg.sws_avoidance) {}
+
+//两个窗口相加,结果超出size_t时取最大值(没有拥塞控制时cwnd就是最大值)
+static size_t saturating_add(const size_t a, const size_t b) {
+    return a > numeric_limits<size_t>::max() - b ? numeric_limits<size_t>::max() : a + b;
+}
+
+//把从stream中读出的BufferList变成一个Buffer作为载荷,只有一块的时候不需要拷贝
+static Buffer to_payload(const BufferList &data) {
+    if (data.buffers().size() <= 1) {
+        return data;
+    }
+    return Buffer(data.concatenate());
+}
 
 uint64_t TCPSender::bytes_in_flight() const { return _bytes_in_flight; }
 
@@ -29,13 +75,24 @@ void TCPSender::do_send(const TCPSegment &seg) {
     size_t current_seqno = _next_seqno;
     size_t send_length = seg.length_in_sequence_space();
     _next_seqno += send_length;
-    SegInfo seg_info = SegInfo(current_seqno + seg.length_in_sequence_space());
+    SegInfo seg_info = SegInfo(current_seqno + seg.length_in_sequence_space(), _now);
+    if (!_bytes_in_flight) {
+        //在途没有数据时,从现在开始测量投递速率
+        _first_sent_time = _delivered_time = _now;
+    }
+    seg_info.delivered = _delivered;
+    seg_info.delivered_time = _delivered_time;
+    seg_info.first_sent_time = _first_sent_time;
+    seg_info.app_limited = _app_limited != 0;
     if (!_timer.working()) {
         //如果当前没有timer,设置一手timer
         _timer.work(_rto);
     }
-    _unack_seg.push(pair<SegInfo, TCPSegment>(seg_info, seg));
+    _unack_seg.emplace_back(seg_info, seg);
     _bytes_in_flight += send_length;
+    if (sack_recovery()) {
+        _pipe += send_length;
+    }
     _segments_out.push(seg);
 }
 
@@ -49,55 +106,83 @@ void TCPSender::fill_window() {
         return;
     } else {
         if (!_window_size) {
-            //如果window的长度为0,那么赋予其1,发送一个字节的内容(即使这个字节没啥意义)
-            _window_size = 1;
-        }
-
-        if (_window_size <= _next_seqno - _max_recv_ackno) {
-			//如果接收者的右窗口边界反而向左移动/当前的窗口大小一斤发完了,直接return
+            //对方的窗口为0,不发新的数据.有数据等着发,又没有在途的数据(重传定时器不工作)时,由持续定时器去探测窗口
+            if (_unack_seg.empty() && !_sent_fin && (!_stream.buffer_empty() || _stream.input_ended())) {
+                _persist_timer.work(persist_timeout());
+            }
             return;
         }
 
-        //计算接收方最多可以接受的大小，由于上面的判断,这里最小是1.
-        size_t max_send_length_by_receiver_window = _window_size - (_next_seqno - _max_recv_ackno);
+        //接收方的窗口限制发出的序号范围,拥塞窗口限制网络中的数据量.
+        //快速恢复期间,没有SACK时用膨胀后的窗口代替拥塞窗口,有SACK时用_pipe代替在途的字节数
+        const size_t cwnd = (_in_recovery && !_sack_used) ? _recovery_window : _congestion_control->cwnd();
+        const auto room = [&] {
+            const size_t in_flight = _next_seqno - _max_recv_ackno;
+            const size_t outstanding = sack_recovery() ? _pipe : in_flight;
+            if (_window_size <= in_flight || cwnd <= outstanding) {
+                //如果接收者的右窗口边界反而向左移动/当前的窗口大小已经发完了
+                return size_t{0};
+            }
+            return min<size_t>(_window_size - in_flight, cwnd - outstanding);
+        };
+
+        //计算最多可以发送的大小
+        size_t max_send_length = room();
+        const auto rate = pacing_rate();
+        _pacing_blocked = false;
         //如果当前不是第一个包,那么我们需要根据当前的窗口等信息发送.
-        while (!_sent_fin && max_send_length_by_receiver_window) {
+        while (!_sent_fin && max_send_length) {
             //如果我们的fin也已经发送出去了,直接不进入while循环
+            if (rate.has_value() && _pacing_budget <= 0) {
+                //这个时间段内的发送额度已经用完了,等下一次tick().还有数据等着发的话记下来,time_until_next_send()要用
+                _pacing_blocked = !_stream.buffer_empty() || _stream.eof();
+                break;
+            }
 
             //从当前窗口值和tcp最大载荷长度中选取最小的一个,然后从stream中读取一手.
-            size_t read_len = min(max_send_length_by_receiver_window, TCPConfig::MAX_PAYLOAD_SIZE) - 1;
-
-            //读取read_len - 1 的内容到read_content1中,read_len至少是0,所以要不就空读,要不就读read_len个字节
-            string read_content1 = _stream.read(read_len);
-
-            //再读取一个字节,如果当前没有出现eof,那么这个字节会加到content1后面,
-            string read_content2 = _stream.read(1);
-            if (!read_content2.size()) {
-                if (_stream.eof()) {
-                    //如果centent2空,并且当前出现了eof,那么我们放置一个eof,正常发送
-                    seg.header().fin = true;
-                    _sent_fin = true;
-                } else if (!read_content1.size()) {
-                    //如果centent2空,并且content1也空,并且没有eof,我们不发任何的包
-                    break;
-                }
-            } else {
-                read_content1 += read_content2;
+            size_t read_len = min(max_send_length, _max_payload);
+            if (hold_partial_segment()) {
+                break;
+            }
+            if (_sws_avoidance && read_len < _max_payload && read_len < _stream.buffer_size() && _bytes_in_flight &&
+                read_len < _max_window / 2) {
+                //数据比窗口多,窗口却凑不满一个段:在途的数据被确认时窗口会打开,那时再发
+                break;
             }
-            seg.payload() = Buffer(move(read_content1));
+            Buffer payload = to_payload(_stream.read_buffers(read_len));
+            if (payload.size() < read_len && _stream.eof()) {
+                //如果stream中剩下的内容都读完了,并且还有至少一个字节的空间,那么放置一个fin,正常发送
+                seg.header().fin = true;
+                _sent_fin = true;
+            } else if (!payload.size()) {
+                //如果什么都没读到,并且没有eof,我们不发任何的包.窗口没有用完是因为没有数据,这时测到的投递速率偏低
+                _app_limited = max<uint64_t>(_delivered + _bytes_in_flight, 1);
+                break;
+            }
+            seg.payload() = move(payload);
 
             seg.header().seqno = wrap(_next_seqno, _isn);
 
             do_send(seg);
-            max_send_length_by_receiver_window = _window_size - (_next_seqno - _max_recv_ackno);
+            if (rate.has_value()) {
+                _pacing_budget -= static_cast<double>(seg.length_in_sequence_space());
+            }
+            max_send_length = room();
         }
     }
 }
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
-//! \param window_size The remote receiver's advertised window size
+//! \param window_size The remote receiver's advertised window size, in bytes
+//! \param pure_ack whether the segment carrying the ACK had no payload, SYN or FIN
+//! \param sack the SACK blocks carried by the segment (if the connection negotiated SACK)
+//! \param ts_echo the TSecr carried by the segment (if the connection negotiated timestamps)
 //! \returns `false` if the ackno appears invalid (acknowledges something the TCPSender hasn't sent yet)
-bool TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+bool TCPSender::ack_received(const WrappingInt32 ackno,
+                             const size_t window_size,
+                             const bool pure_ack,
+                             const vector<TCPHeader::SackBlock> &sack,
+                             const optional<uint32_t> ts_echo) {
     size_t seqno = unwrap(ackno, _isn, _max_recv_ackno);
     if (seqno > _next_seqno) {
         //如果seqno确认的是当前还没发的字节,那么非法,返回false
@@ -105,13 +190,216 @@ bool TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
     } else if (seqno < _max_recv_ackno) {
         //如果已经确认过了,直接返回true,不做处理
         return true;
+    }
+
+    update_scoreboard(sack);
+    bool partial_ack = false;
+    if (seqno == _max_recv_ackno) {
+        //没有确认新的数据.有数据在途,不带数据,窗口也没有变化的ack才是重复ack(RFC 5681的定义),
+        //对方携带数据的段和窗口更新都不算.窗口为0时的ack是对方在回应窗口探测,也不算
+        if (pure_ack && _bytes_in_flight && window_size && window_size == _window_size) {
+            on_duplicate_ack();
+        }
+        _window_size = window_size;
+        _max_window = max(_max_window, window_size);
     } else {
+        //新确认的字节数,SYN不算在内(握手不应该让拥塞窗口增长)
+        const size_t first_byte = max<size_t>(_max_recv_ackno, 1);
+        const size_t acked_bytes = seqno > first_byte ? seqno - first_byte : 0;
         _max_recv_ackno = seqno;
-        check_unack_seg(seqno);
+        _dup_acks = 0;
+        //对方回显的是触发这个ack的那个段发出的时间,重传的段也一样(RFC 7323 4.1),
+        //所以确认了重传过的段的ack也能测量rtt,超时时间不必一直保持退避之后的值.
+        //回显的时间比现在还晚的话,说明对方回显的不是我们的时钟
+        optional<uint64_t> ts_rtt;
+        if (ts_echo.has_value() && timestamp() - ts_echo.value() <= _now) {
+            ts_rtt = timestamp() - ts_echo.value();
+        }
+        const auto acked_seg = check_unack_seg(seqno, ts_rtt);
+        //结束快速恢复的那个ack也不让窗口增长,窗口就从ssthresh开始
+        const bool in_recovery = _in_recovery;
+        if (seqno >= _recover) {
+            //确认了进入丢包恢复(或者超时)时发出的所有数据,退出恢复,窗口回到拥塞控制给出的ssthresh
+            _in_recovery = false;
+            _rto_recovery = false;
+        } else if (_sack_used) {
+            //有SACK时由记分板决定重传哪些段,不过和下面一样,确认号后面的段一定丢了
+            partial_ack = true;
+        } else if (_in_recovery) {
+            //部分确认(RFC 6582):下一个丢失的段紧跟在确认号后面,马上重传它,
+            //窗口减去新确认的字节数,如果确认了至少一个mss再加回一个mss
+            retransmit_front();
+            _recovery_window -= min(_recovery_window, acked_bytes);
+            if (acked_bytes >= TCPConfig::MAX_PAYLOAD_SIZE) {
+                _recovery_window = saturating_add(_recovery_window, TCPConfig::MAX_PAYLOAD_SIZE);
+            }
+        } else if (_adaptive_rto && _rto_recovery && !_unack_seg.empty() &&
+                   !_unack_seg.front().first.recovery_retransmitted) {
+            //超时之后的部分确认:确认号后面的段也是超时之前发出的,很可能同样丢了,马上重传它.
+            //自适应的超时时间按Karn算法会一直保持退避之后的值,不这样做的话每个空洞都要等一次越来越长的超时.
+            //固定超时时间时每次确认都会把超时时间恢复成初始值,保持lab要求的行为:下一个段等满一个超时再重传
+            retransmit_front();
+        }
+        if (acked_bytes) {
+            _delivered += acked_bytes;
+            _delivered_time = _now;
+            if (_app_limited && _delivered > _app_limited) {
+                _app_limited = 0;
+            }
+
+            CongestionControl::AckEvent ack{_now, acked_bytes, _bytes_in_flight, {}, seqno, _next_seqno};
+            ack.in_recovery = in_recovery;
+            if (acked_seg.has_value()) {
+                //拥塞控制只用按发送时间测到的rtt,它们关心的是最小rtt,用不着重传时的样本
+                if (!acked_seg->retransmitted) {
+                    ack.rtt = _now - acked_seg->send_time;
+                }
+                //发送和确认两个方向上经过的时间取较长的一个,避免ack压缩让速率偏高
+                const uint64_t interval = max(acked_seg->send_time - acked_seg->first_sent_time,
+                                              _now - acked_seg->delivered_time);
+                if (interval) {
+                    ack.delivery_rate = static_cast<double>(_delivered - acked_seg->delivered) / interval;
+                    ack.app_limited = acked_seg->app_limited;
+                }
+                _first_sent_time = acked_seg->send_time;
+            }
+            _congestion_control->on_ack(ack);
+        }
         _window_size = window_size;
-        fill_window();
+        _max_window = max(_max_window, window_size);
+    }
+    update_persist_timer();
+
+    if (_sack_used && !_in_recovery && !_rto_recovery && _max_recv_ackno > _recover && front_lost()) {
+        //记分板显示确认号后面的段已经丢了,不必等够三个重复ack(RFC 6675)
+        enter_recovery();
+    } else if (sack_recovery()) {
+        sack_retransmit(partial_ack);
+    }
+    resize_stream();
+    fill_window();
+    return true;
+}
+
+void TCPSender::update_persist_timer() {
+    if (!_persist_timer.working()) {
+        return;
+    }
+    if (_window_size) {
+        //窗口打开了:停止探测,接下来的fill_window()按照新的窗口全速发送.
+        //确认号没有越过探测,说明对方是在窗口打开之前收到它的,已经丢掉了,马上和后面的数据一起重新发出去
+        _persist_timer.stop();
+        _persist_backoff = 0;
+        if (!_unack_seg.empty()) {
+            retransmit_front();
+            _timer.work(_rto);
+        }
+    } else {
+        //探测期间确认了部分数据也会重新启动重传定时器,窗口还是0就仍然只由持续定时器发送
+        _timer.stop();
+    }
+}
+
+size_t TCPSender::persist_timeout() const {
+    size_t timeout = _rto;
+    for (unsigned i = 0; i < _persist_backoff && timeout < TCPConfig::PERSIST_TIMEOUT_MAX_MS; i++) {
+        timeout *= 2;
+    }
+    return min<size_t>(timeout, max<size_t>(_rto, TCPConfig::PERSIST_TIMEOUT_MAX_MS));
+}
+
+void TCPSender::send_window_probe() {
+    if (_unack_seg.empty()) {
+        //没有在途的数据时,探测带上窗口外的下一个字节,窗口打开了的话对方就会收下它
+        TCPSegment seg{};
+        seg.payload() = to_payload(_stream.read_buffers(1));
+        if (!seg.payload().size()) {
+            if (!_stream.eof() || _sent_fin) {
+                return;
+            }
+            seg.header().fin = true;
+            _sent_fin = true;
+        }
+        seg.header().seqno = wrap(_next_seqno, _isn);
+        do_send(seg);
+        _timer.stop();
+    } else {
+        //窗口缩小到0的时候还有在途的数据,就用它的第一个段做探测
+        retransmit_front();
+    }
+    _persist_backoff++;
+    _persist_timer.work(persist_timeout());
+}
+
+void TCPSender::resize_stream() {
+    if (!_autotune) {
+        return;
+    }
+    const size_t current = _stream.capacity();
+    size_t target = _min_capacity;
+    if (!TCPMemory::under_pressure()) {
+        //对方的窗口更小时拥塞窗口用不满,缓冲区不必跟着拥塞窗口长
+        const size_t window = min(_congestion_control->cwnd(), _window_size);
+        target = _memory.affordable(clamp(2 * window, _min_capacity, _max_capacity));
+        if (target <= current) {
+            return;
+        }
+    }
+    if (target != current) {
+        _stream.set_capacity(target);
+        _memory.resize(_stream.capacity());
+    }
+}
+
+bool TCPSender::hold_partial_segment() {
+    const size_t buffered = _stream.buffer_size();
+    //能凑满一个段,或者后面不会再有数据了,或者是push()之前写入的数据,都不需要等
+    if (buffered == 0 || buffered >= _max_payload || _stream.input_ended() || _stream.bytes_read() < _push_mark) {
+        _held_since.reset();
+        return false;
+    }
+    if (_cork) {
+        if (!_held_since.has_value()) {
+            _held_since = _now;
+        }
+        //和Linux一样,cork最多把数据留200ms
+        if (_now - _held_since.value() < TCPConfig::CORK_TIMEOUT_MS) {
+            return true;
+        }
+    } else if (_nagle && _bytes_in_flight > 0) {
         return true;
     }
+    _held_since.reset();
+    return false;
+}
+
+optional<double> TCPSender::pacing_rate() const {
+    if (const auto rate = _congestion_control->pacing_rate(); rate.has_value()) {
+        return rate;
+    }
+    if (!_pacing) {
+        return {};
+    }
+    if (_fixed_pacing_rate > 0) {
+        return _fixed_pacing_rate;
+    }
+    //还没有rtt样本,或者没有拥塞窗口的时候,没有办法算出速率
+    const size_t cwnd = _congestion_control->cwnd();
+    if (!_rtt.samples() || cwnd == numeric_limits<size_t>::max()) {
+        return {};
+    }
+    const double gain = cwnd < _congestion_control->ssthresh() ? PACING_GAIN_SLOW_START : PACING_GAIN;
+    //rtt的精度只有1ms,在本地回环上可能测出0
+    return gain * static_cast<double>(cwnd) / max(_rtt.srtt(), 1.0);
+}
+
+optional<uint64_t> TCPSender::time_until_next_send() const {
+    const auto rate = pacing_rate();
+    if (!_pacing_blocked || !rate.has_value()) {
+        return {};
+    }
+    //tick()按整数毫秒积累额度,所以至少要等1ms
+    return max<uint64_t>(1, static_cast<uint64_t>(ceil(-_pacing_budget / rate.value())));
 }
 
 bool TCPSender::check_ack_legal(const WrappingInt32 ackno) {
@@ -126,18 +414,158 @@ bool TCPSender::check_ack_legal(const WrappingInt32 ackno) {
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
+    _now += ms_since_last_tick;
+    if (const auto rate = pacing_rate(); rate.has_value()) {
+        //额度最多攒下这一次tick的量再加两个段,防止空闲一段时间之后一下子发出一大串
+        const double refill = rate.value() * static_cast<double>(ms_since_last_tick);
+        _pacing_budget = min(_pacing_budget + refill, refill + 2.0 * TCPConfig::MAX_PAYLOAD_SIZE);
+    }
+    //空闲的连接收不到ack,内存紧张时也要靠tick()缩小缓冲区
+    if (TCPMemory::under_pressure()) {
+        resize_stream();
+    }
+    //两个定时器都先走完这段时间,超时处理中重新启动的定时器不能再减去它
     bool overtime = _timer.refresh(ms_since_last_tick);
+    const bool persist_expired = _persist_timer.refresh(ms_since_last_tick);
     if (overtime) {
         //如果超时,重新发送_unack_seg中的第一个TCPSeg
         do_resend();
     }
+    if (persist_expired) {
+        send_window_probe();
+    }
 }
 
-void TCPSender::do_resend() {
+void TCPSender::retransmit_front() {
     if (!_unack_seg.empty()) {
         _segments_out.push(_unack_seg.front().second);
+        _unack_seg.front().first.retransmitted = true;
+        _unack_seg.front().first.recovery_retransmitted = true;
+    }
+}
+
+void TCPSender::enter_recovery() {
+    _congestion_control->on_loss(_bytes_in_flight);
+    _in_recovery = true;
+    _recover = _next_seqno;
+    //收到三个重复ack说明有三个段已经离开了网络(RFC 5681 3.2)
+    _recovery_window =
+        saturating_add(_congestion_control->cwnd(), DUP_ACK_THRESHOLD * TCPConfig::MAX_PAYLOAD_SIZE);
+    if (_sack_used) {
+        for (auto &entry : _unack_seg) {
+            entry.first.recovery_retransmitted = false;
+        }
+        sack_retransmit(true);
+    } else {
+        retransmit_front();
+    }
+}
+
+void TCPSender::update_scoreboard(const vector<TCPHeader::SackBlock> &sack) {
+    for (const auto &[left, right] : sack) {
+        const uint64_t begin = unwrap(left, _isn, _max_recv_ackno);
+        const uint64_t end = unwrap(right, _isn, _max_recv_ackno);
+        if (begin >= end || end > _next_seqno) {
+            //不合法的块,忽略
+            continue;
+        }
+        _sack_used = true;
+        //只标记整个落在块里面的段.段是按序号排好的,越过块的右边界就可以停下
+        for (auto &[info, seg] : _unack_seg) {
+            const size_t length = seg.length_in_sequence_space();
+            const uint64_t seg_begin = info.absolute_seqno - length;
+            if (seg_begin >= end) {
+                break;
+            }
+            if (!info.sacked && seg_begin >= begin && info.absolute_seqno <= end) {
+                info.sacked = true;
+                _sacked_bytes += length;
+            }
+        }
+    }
+}
+
+bool TCPSender::front_lost() const {
+    //被sack的段都在第一个段后面.后面被sack的字节超过(DUP_ACK_THRESHOLD - 1)个mss,就和收到了三个重复ack一样
+    return !_unack_seg.empty() && !_unack_seg.front().first.sacked &&
+           _sacked_bytes > (DUP_ACK_THRESHOLD - 1) * TCPConfig::MAX_PAYLOAD_SIZE;
+}
+
+void TCPSender::sack_retransmit(const bool force_front) {
+    //从后往前累计每个段后面被sack的字节数,标出已经丢失的段(RFC 6675 IsLost).
+    //越靠前的段后面被sack的越多,所以丢失的段总是_unack_seg中没被sack的段的一个前缀
+    size_t sacked_above = 0;
+    for (auto it = _unack_seg.rbegin(); it != _unack_seg.rend(); ++it) {
+        SegInfo &info = it->first;
+        info.lost = !info.sacked && sacked_above > (DUP_ACK_THRESHOLD - 1) * TCPConfig::MAX_PAYLOAD_SIZE;
+        if (info.sacked) {
+            sacked_above += it->second.length_in_sequence_space();
+        }
+    }
+
+    //网络中的字节数:没被sack,而且没有丢失或者丢失之后已经重传过的段(RFC 6675 SetPipe)
+    _pipe = 0;
+    for (const auto &[info, seg] : _unack_seg) {
+        if (!info.sacked && (!info.lost || info.recovery_retransmitted)) {
+            _pipe += seg.length_in_sequence_space();
+        }
+    }
+
+    //按顺序重传丢失了还没有重传过的段,直到网络中的数据量达到拥塞窗口
+    const size_t cwnd = _congestion_control->cwnd();
+    for (auto &[info, seg] : _unack_seg) {
+        if (info.sacked || info.recovery_retransmitted) {
+            continue;
+        }
+        if (!(force_front && &info == &_unack_seg.front().first) && (!info.lost || _pipe >= cwnd)) {
+            break;
+        }
+        _segments_out.push(seg);
+        info.retransmitted = true;
+        info.recovery_retransmitted = true;
+        if (info.lost) {
+            _pipe += seg.length_in_sequence_space();
+        }
+    }
+}
+
+void TCPSender::on_duplicate_ack() {
+    _dup_acks++;
+    if (_in_recovery) {
+        //每个重复ack说明又有一个段离开了网络,窗口膨胀一个mss,让新的数据可以发出去
+        _recovery_window = saturating_add(_recovery_window, TCPConfig::MAX_PAYLOAD_SIZE);
+    } else if (_dup_acks == DUP_ACK_THRESHOLD && _max_recv_ackno > _recover) {
+        //快速重传:确认号后面的段很可能丢了,不等超时直接重传它.
+        //确认号没有越过_recover时,这些重复ack可能是同一个窗口里的其他丢包或者上一次的重传引起的,
+        //不能再次减小窗口(RFC 6582 3.2 step 2)
+        enter_recovery();
+    }
+}
+
+void TCPSender::do_resend() {
+    if (!_unack_seg.empty() && !_window_size) {
+        //对方的窗口是0,在途的数据没被确认不是因为丢包,不缩小拥塞窗口也不计入重传次数,改由持续定时器探测
+        send_window_probe();
+    } else if (!_unack_seg.empty()) {
+        if (!_unack_seg.front().first.overtime_times) {
+            //同一个段连续超时的时候,只在第一次超时时缩小窗口(RFC 5681),否则ssthresh会被一直压到最小
+            _congestion_control->on_rto(_bytes_in_flight);
+        }
+        //超时之后结束快速恢复,在已经发出的数据都被确认之前不再快速重传(RFC 6582 4.).
+        //这段时间里收到部分确认就接着重传后面丢失的段(有SACK时按照记分板),而不是每个都等一次超时
+        _in_recovery = false;
+        _rto_recovery = true;
+        _dup_acks = 0;
+        _recover = _next_seqno;
+        for (auto &entry : _unack_seg) {
+            entry.first.recovery_retransmitted = false;
+        }
+        retransmit_front();
         _unack_seg.front().first.overtime_times++;
         _rto *= 2;
+        if (_adaptive_rto) {
+            _rto = min<size_t>(_rto, _rto_max);
+        }
         _timer.work(_rto);
     }
 }
@@ -156,27 +584,55 @@ void TCPSender::send_empty_segment() {
     _segments_out.push(seg);
 }
 
-void TCPSender::check_unack_seg(const size_t ack_abs_seqno) {
+optional<TCPSender::SegInfo> TCPSender::check_unack_seg(const size_t ack_abs_seqno, const optional<uint64_t> ts_rtt) {
     bool ack_ok = false;  //判断当前的ack是不是合法的ack,如果是合法的ack,设置rto
+    optional<SegInfo> acked;
+    bool retransmission_acked = false;
     while (!_unack_seg.empty()) {
         //逻辑:从_unack_seg的首部出发,向后遍历一手,如果当前的TCPSegment的最后一个字符也得到了确认,那么从_unack_seg中删除掉.
         if (ack_abs_seqno >= _unack_seg.front().first.absolute_seqno) {
+            if (!_unack_seg.front().first.retransmitted) {
+                acked = _unack_seg.front().first;
+            } else {
+                retransmission_acked = true;
+            }
             size_t ack_bytes_num = _unack_seg.front().second.length_in_sequence_space();
             _bytes_in_flight -= ack_bytes_num;
-            _unack_seg.pop();
+            if (_unack_seg.front().first.sacked) {
+                _sacked_bytes -= ack_bytes_num;
+            }
+            _unack_seg.pop_front();
             ack_ok = true;
         } else {
             break;
         }
     }
+    if (acked.has_value() && retransmission_acked) {
+        //重传过的段分不清ack对应的是哪一次发送,不能用来测rtt.同一个ack里后面没重传过的段也不行:
+        //它们早就到了,只是在等前面的空洞被补上,测出来的是修补空洞的时间.速率的估计仍然可以用
+        acked->retransmitted = true;
+    }
     if (ack_ok) {
-        _rto = _initial_retransmission_timeout;
+        optional<uint64_t> sample = ts_rtt;
+        if (acked.has_value() && !acked->retransmitted) {
+            sample = _now - acked->send_time;
+        }
+        if (sample.has_value()) {
+            _rtt.add_sample(sample.value());
+        }
+        //自适应时,如果被确认的段都重传过(并且没有时间戳),就没有新的rtt样本,按照Karn算法保留退避之后的超时时间
+        if (!_adaptive_rto) {
+            _rto = _initial_retransmission_timeout;
+        } else if (sample.has_value()) {
+            _rto = _rtt.rto(_rto_min, _rto_max).value();
+        }
         _timer.stop();
         if (!_unack_seg.empty()) {
             //根据lab3.pdf,如果当前还有未被确认的seg,那么重新定时定时器.
             _timer.work(_rto);
         }
     }
+    return acked;
 }
 
 WrappingInt32 TCPSender::get_seqno(){
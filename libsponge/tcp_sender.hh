@@ -2,12 +2,21 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
+#include "tcp_memory.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <optional>
+#include <deque>
 #include <queue>
+#include <vector>
 
 //定时器,如果在工作,表示的是当前_unack_seg中的位于队头的pair有没有超时.
 class TCPTimer {
@@ -52,7 +61,66 @@ class TCPTimer {
     }
 
     // working 是否正在工作
-    bool working() { return _working; }
+    bool working() const { return _working; }
+};
+
+//! \brief Round-trip time statistics of a connection, and the retransmission timeout they give (RFC 6298)
+class RTTEstimator {
+  private:
+    //RFC 6298 2.3的参数: alpha = 1/8, beta = 1/4, K = 4
+    static constexpr double ALPHA = 0.125;
+    static constexpr double BETA = 0.25;
+    static constexpr double K = 4;
+    //时钟粒度G,时间是tick()的参数之和,单位ms
+    static constexpr double GRANULARITY_MS = 1;
+
+    uint64_t _samples = 0;
+    double _srtt = 0;
+    double _rttvar = 0;
+    uint64_t _latest = 0;
+    uint64_t _min = 0;
+    uint64_t _max = 0;
+
+  public:
+    //! \brief Take a round-trip time measurement (never from an ambiguous retransmission, per Karn's algorithm)
+    void add_sample(const uint64_t rtt) {
+        const double r = static_cast<double>(rtt);
+        if (!_samples) {
+            //第一个样本(RFC 6298 2.2)
+            _srtt = r;
+            _rttvar = r / 2;
+            _min = _max = rtt;
+        } else {
+            //之后的样本(RFC 6298 2.3),rttvar要用更新之前的srtt
+            _rttvar = (1 - BETA) * _rttvar + BETA * (_srtt > r ? _srtt - r : r - _srtt);
+            _srtt = (1 - ALPHA) * _srtt + ALPHA * r;
+            _min = std::min(_min, rtt);
+            _max = std::max(_max, rtt);
+        }
+        _latest = rtt;
+        _samples++;
+    }
+
+    //! \brief The retransmission timeout, clamped to [rto_min, rto_max]
+    //! \returns nothing before the first measurement
+    std::optional<uint64_t> rto(const uint64_t rto_min, const uint64_t rto_max) const {
+        if (!_samples) {
+            return {};
+        }
+        //向上取整,定时器只能精确到ms
+        const auto rto = static_cast<uint64_t>(std::ceil(_srtt + std::max(GRANULARITY_MS, K * _rttvar)));
+        return std::clamp(rto, rto_min, rto_max);
+    }
+
+    //! \name Per-connection statistics (all in milliseconds)
+    //!@{
+    uint64_t samples() const { return _samples; }  //!< Number of measurements taken
+    double srtt() const { return _srtt; }          //!< Smoothed round-trip time
+    double rttvar() const { return _rttvar; }      //!< Round-trip time variation
+    uint64_t latest() const { return _latest; }    //!< Most recent measurement
+    uint64_t min() const { return _min; }          //!< Smallest measurement
+    uint64_t max() const { return _max; }          //!< Largest measurement
+    //!@}
 };
 
 //! \brief The "sender" part of a TCP implementation.
@@ -78,34 +146,147 @@ class TCPSender {
     //! the (absolute) sequence number for the next byte to be sent
     uint64_t _next_seqno{0};
 
-    uint16_t _window_size = 1;
+    //对方通告的窗口(字节数,已经按窗口扩大选项放大过)
+    size_t _window_size = 1;
     //超时使用,从_unack_seg中取出第一个tcpseg,并且重新发送一手
     void do_resend();
 
+    //重新发送_unack_seg中的第一个tcpseg(超时重传和快速重传共用)
+    void retransmit_front();
+
+    //快速重传_unack_seg中第一个段,进入快速恢复
+    void enter_recovery();
+
+    //收到了一个重复ack,第DUP_ACK_THRESHOLD个时快速重传并进入快速恢复
+    void on_duplicate_ack();
+
     //正常使用,发送一个tcpseg,并且进行timer的检查,放到_unack_seg中等工作.
     void do_send(const TCPSegment &);
 
     //当前的超时时间
     size_t _rto;
+    //为true时按照测量到的rtt计算超时时间(RFC 6298),并限制在[_rto_min, _rto_max]之内;
+    //为false时每次收到新的确认都把超时时间恢复成_initial_retransmission_timeout
+    bool _adaptive_rto;
+    uint64_t _rto_min;
+    uint64_t _rto_max;
+    RTTEstimator _rtt{};
     size_t _max_recv_ackno = 0;
-    //因为queue不支持遍历,所以这个字段用于记录当前queue中有多少个有效载荷
+    //_unack_seg中有多少个有效载荷
     size_t _bytes_in_flight = 0;
     // size_t _first_unack_abs_seqno = 0;
     //用于存放_unack_seg中的段的信息
     struct SegInfo {
         size_t absolute_seqno = 0;  //本段最后一个字符的下一个字符的在absolute seqno中的位置
         size_t overtime_times = 0;  //本段超时次数
-        SegInfo(size_t seqno) : absolute_seqno(seqno) {}
+        uint64_t send_time = 0;     //本段第一次发送的时间,用于测量rtt
+        //发送本段时的投递状态,本段被确认时用来计算投递速率
+        uint64_t delivered = 0;
+        uint64_t delivered_time = 0;
+        uint64_t first_sent_time = 0;
+        bool app_limited = false;
+        bool retransmitted = false;  //本段是否重传过(超时或者快速重传)
+        //SACK记分板
+        bool sacked = false;                  //对方是否已经sack了本段
+        bool lost = false;                    //根据sack判断本段已经丢失(RFC 6675 IsLost)
+        bool recovery_retransmitted = false;  //本次丢包恢复中是否已经重传过
+        SegInfo(size_t seqno, uint64_t now) : absolute_seqno(seqno), send_time(now) {}
     };
     //保存 <本段的SegInfo , 还没有收到确认的段>组成的pair
     //如果发生了超时,则将队头的第一个发送出去.注意pair.first应该是在队列中有序的.
-    std::queue<std::pair<SegInfo, TCPSegment>> _unack_seg{};
-    //收到ack后,检查_unack_seg,查看其中得到确认的段,将其删除
-    void check_unack_seg(const size_t seqno);
+    //用deque是因为SACK需要遍历所有在途的段
+    std::deque<std::pair<SegInfo, TCPSegment>> _unack_seg{};
+    //收到ack后,检查_unack_seg,查看其中得到确认的段,将其删除.
+    //如果被确认的段中有没有重传过的,返回最后一个这样的段,用来测量rtt和投递速率(Karn算法).
+    //这次确认的段里有重传过的时,返回的段也标记为retransmitted,不能用来测量rtt,
+    //这时如果有根据时间戳选项测到的rtt(ts_rtt),就用它.对方攒了几个段才确认时,回显的是第一个段的时间,
+    //测出来的偏大,所以能按发送时间测量的时候还是按发送时间
+    std::optional<SegInfo> check_unack_seg(const size_t seqno, const std::optional<uint64_t> ts_rtt);
     TCPTimer _timer = {};
     //是否已经发送了fin位
     bool _sent_fin = false;
 
+    //当前的时间,即所有tick()的参数之和,单位ms
+    uint64_t _now = 0;
+
+    //新的段最多带多少字节的载荷.每个段都要带选项时(比如时间戳),要给选项留出位置
+    size_t _max_payload = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    //拥塞控制算法,发送时在途的字节数不超过min(cwnd, 接收方的窗口)
+    std::unique_ptr<CongestionControl> _congestion_control;
+
+    //投递速率的估计(draft-cheng-iccrg-delivery-rate-estimation):
+    //一个段被确认时,用它发送之后新确认的字节数除以经过的时间
+    uint64_t _delivered = 0;        //到目前为止被确认的字节数
+    uint64_t _delivered_time = 0;   //最近一次有数据被确认的时间
+    uint64_t _first_sent_time = 0;  //最近一个被确认的段的发送时间
+    uint64_t _app_limited = 0;      //不为0时,_delivered达到这个值之前发出的段都是因为没有数据可发而没有发满的
+
+    //快速重传和快速恢复(RFC 5681 3.2, RFC 6582)
+    static constexpr unsigned DUP_ACK_THRESHOLD = 3;
+    unsigned _dup_acks = 0;       //连续收到的重复ack的个数
+    bool _in_recovery = false;    //是否处于快速恢复中
+    uint64_t _recover = 0;        //进入快速恢复(或者超时)时发出的最大序号,确认越过它之前不会再次进入快速恢复
+    size_t _recovery_window = 0;  //快速恢复期间代替cwnd的窗口,重复ack会让它膨胀
+
+    //SACK(RFC 2018):记分板记录_unack_seg中哪些段已经被对方收到,丢包恢复时只重传丢失的段(RFC 6675)
+    bool _sack_used = false;     //是否收到过SACK块
+    size_t _sacked_bytes = 0;    //_unack_seg中被sack了的字节数
+    bool _rto_recovery = false;  //超时之后,确认越过_recover之前,同样按照记分板重传丢失的段
+    size_t _pipe = 0;            //按照记分板估计的网络中的字节数,丢包恢复期间代替在途的字节数
+
+    //按照收到的SACK块标记_unack_seg中的段
+    void update_scoreboard(const std::vector<TCPHeader::SackBlock> &sack);
+    //_unack_seg的第一个段是否已经可以认为丢失了
+    bool front_lost() const;
+    //是否按照记分板做丢包恢复
+    bool sack_recovery() const { return _sack_used && (_in_recovery || _rto_recovery); }
+    //重新计算_pipe,并在拥塞窗口允许的范围内重传丢失的段.force_front为true时第一个段即使没有被认为丢失,
+    //只要这次恢复中还没有重传过,也马上重传
+    void sack_retransmit(const bool force_front);
+
+    //拥塞控制给出了发送速率,或者打开了_pacing时,按照速率发送新的数据:tick()积累额度,每发一个段扣掉它的长度.
+    //额度是小数,一毫秒内发不完一个段的速率也能按平均速率发送
+    double _pacing_budget = 0;
+    bool _pacing;
+    double _fixed_pacing_rate;  //单位是字节/ms,0表示按照cwnd / srtt计算
+    //上一次fill_window()是不是因为额度用完了才停下的,是的话time_until_next_send()给出额度够用的时间
+    bool _pacing_blocked = false;
+    //按cwnd / srtt计算速率时乘上的系数:慢启动时每个rtt窗口翻倍,速率也要跟得上(和Linux一样)
+    static constexpr double PACING_GAIN_SLOW_START = 2.0;
+    static constexpr double PACING_GAIN = 1.2;
+
+    //不满一个段的数据是不是要先留着:_nagle时等在途的数据被确认,_cork时等解除或者超时.
+    //push()之前写入的数据不受影响,一直到_push_mark都可以立即发送
+    bool _nagle;
+    bool _cork;
+    uint64_t _push_mark = 0;
+    std::optional<uint64_t> _held_since{};  //cork开始留下数据的时间
+    bool hold_partial_segment();
+
+    //_autotune时发送缓冲区从_min_capacity开始,跟着拥塞窗口扩大到_max_capacity:
+    //能放下两个窗口的数据,一个在途,一个等着发.只在超出了进程的内存预算(TCPMemory)时缩小
+    bool _autotune;
+    size_t _min_capacity;
+    size_t _max_capacity;
+    TCPMemory::Charge _memory;
+    void resize_stream();
+
+    //避免糊涂窗口综合症(RFC 1122 4.2.3.4):有数据在途时,被窗口截短的段要等到至少有_max_window的一半才发,
+    //否则等下一个ack把窗口打开
+    bool _sws_avoidance;
+    size_t _max_window = 0;  //对方通告过的最大的窗口
+
+    //持续定时器(RFC 9293 3.8.6.1):对方的窗口为0时不再发送新的数据,到时间后发一个字节的窗口探测,
+    //间隔从_rto开始每次翻倍,最多PERSIST_TIMEOUT_MAX_MS.探测不算重传,不会让consecutive_retransmissions()增加,
+    //窗口打开之后马上停止
+    TCPTimer _persist_timer{};
+    unsigned _persist_backoff = 0;  //这次窗口为0以来发出的探测的个数
+    size_t persist_timeout() const;
+    void send_window_probe();
+    //收到对方的窗口之后,决定持续定时器和重传定时器由谁来工作
+    void update_persist_timer();
+
   public:
   //得到一个合法的seqno,如果发送队列不是空的,将发送队列中的首个段的seqno返回,否则返回seqno
     WrappingInt32 get_seqno();
@@ -118,6 +299,9 @@ class TCPSender {
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
               const std::optional<WrappingInt32> fixed_isn = {});
 
+    //! Initialize a TCPSender with every sender option of a connection's configuration
+    explicit TCPSender(const TCPConfig &cfg);
+
     //! \name "Input" interface for the writer
     //!@{
     ByteStream &stream_in() { return _stream; }
@@ -128,7 +312,17 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    bool ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param pure_ack whether the segment carrying the ACK had no payload, SYN or FIN
+    //! (only such ACKs can be duplicate ACKs)
+    //! \param window_size the receiver's window in bytes (already scaled, if the connection negotiated
+    //! window scaling)
+    //! \param sack the SACK blocks carried by the segment (if the connection negotiated SACK)
+    //! \param ts_echo the TSecr carried by the segment (if the connection negotiated timestamps)
+    bool ack_received(const WrappingInt32 ackno,
+                      const size_t window_size,
+                      const bool pure_ack = true,
+                      const std::vector<TCPHeader::SackBlock> &sack = {},
+                      const std::optional<uint32_t> ts_echo = {});
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -138,6 +332,15 @@ class TCPSender {
 
     //! \brief Notifies the TCPSender of the passage of time
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Limit the payload of segments sent from now on, e.g. to leave room for options in every segment
+    void set_max_payload(const size_t max_payload) { _max_payload = max_payload; }
+
+    //! \brief Let everything written so far go out, even as partial segments (see TCPConfig::nagle and cork)
+    void push() { _push_mark = _stream.bytes_written(); }
+
+    //! \brief Hold back partial segments (until uncorked, pushed, or TCPConfig::CORK_TIMEOUT_MS)
+    void set_cork(const bool cork) { _cork = cork; }
     //!@}
 
     //! \name Accessors
@@ -149,8 +352,37 @@ class TCPSender {
     size_t bytes_in_flight() const;
 
     //! \brief Number of consecutive retransmissions that have occurred in a row
+    //! \note zero-window probes are not counted
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Is the persist timer probing a zero window?
+    bool probing_zero_window() const { return _persist_timer.working(); }
+
+    //! \brief The current retransmission timeout, in milliseconds (including any exponential backoff)
+    size_t rto() const { return _rto; }
+
+    //! \brief Round-trip time statistics of the connection
+    const RTTEstimator &rtt() const { return _rtt; }
+
+    //! \brief The rate at which new segments are paced, in bytes per millisecond (none if they are not paced)
+    std::optional<double> pacing_rate() const;
+
+    //! \brief Milliseconds until the pacer lets the next segment out, if it is holding data back
+    //! \note fill_window() (which TCPConnection::tick() calls) sends it; an event loop can sleep until then
+    std::optional<uint64_t> time_until_next_send() const;
+
+    //! \brief The clock for the timestamps option (TSval): milliseconds since the TCPSender was created
+    uint32_t timestamp() const { return static_cast<uint32_t>(_now); }
+
+    //! \brief Is the sender in fast recovery (after a fast retransmit)?
+    bool in_fast_recovery() const { return _in_recovery; }
+
+    //! \brief Bytes in flight that the receiver has selectively acknowledged
+    size_t sacked_bytes() const { return _sacked_bytes; }
+
+    //! \brief The congestion-control algorithm (and its current window)
+    const CongestionControl &congestion_control() const { return *_congestion_control; }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
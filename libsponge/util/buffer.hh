@@ -13,14 +13,25 @@
 //! \brief A reference-counted read-only string that can discard bytes from the front
 class Buffer {
   private:
-    std::shared_ptr<std::string> _storage{};
+    std::shared_ptr<const char> _storage{};  //指向存储的第一个字节,同时持有整块存储(string或者裸内存)
+    size_t _storage_size{};
     size_t _starting_offset{};
+    size_t _removed_suffix{};  //尾部被丢弃(不可见)的字节数,用于在不拷贝的情况下截取Buffer的前缀
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept {
+        auto owner = std::make_shared<std::string>(std::move(str));
+        _storage = std::shared_ptr<const char>(owner, owner->data());
+        _storage_size = owner->size();
+    }
+
+    //! \brief Construct by sharing ownership of `size` bytes of raw storage
+    //! \note Lets a reader fill memory that was never zero-filled (e.g. with readv) and keep it without a copy.
+    Buffer(std::shared_ptr<const char> storage, const size_t size) noexcept
+        : _storage(std::move(storage)), _storage_size(size) {}
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -28,7 +39,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage.get() + _starting_offset, _storage_size - _starting_offset - _removed_suffix};
     }
 
     operator std::string_view() const { return str(); }
@@ -40,12 +51,19 @@ class Buffer {
     //! \brief Size of the string
     size_t size() const { return str().size(); }
 
+    //! \brief Size of the storage this Buffer keeps alive, including bytes discarded from either end
+    size_t storage_size() const { return _storage ? _storage_size : 0; }
+
     //! \brief Make a copy to a new std::string
     std::string copy() const { return std::string(str()); }
 
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Other copies of the Buffer that share the same storage are unaffected.
+    void remove_suffix(const size_t n);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -101,6 +119,9 @@ class BufferViewList {
     //! \name Constructors
     //!@{
 
+    //! \brief Construct an empty list of views
+    BufferViewList() = default;
+
     //! \brief Construct from a std::string
     //将string类型转换为string_view类型
     BufferViewList(const std::string &str) : BufferViewList(std::string_view(str)) {}
@@ -117,6 +138,13 @@ class BufferViewList {
     BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
     //!@}
 
+    //! \brief Append a view to the end of the list (empty views are skipped)
+    void append(std::string_view str) {
+        if (not str.empty()) {
+            _views.push_back(str);
+        }
+    }
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     void remove_prefix(size_t n);
 
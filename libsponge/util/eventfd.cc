@@ -0,0 +1,22 @@
+#include "eventfd.hh"
+
+#include "util.hh"
+
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+EventFD::EventFD() : FileDescriptor(SystemCall("eventfd", ::eventfd(0, EFD_CLOEXEC))) {}
+
+void EventFD::notify() {
+    const uint64_t one = 1;
+    SystemCall("write", ::write(fd_num(), &one, sizeof(one)));
+}
+
+void EventFD::wait() {
+    uint64_t count = 0;
+    SystemCall("read", ::read(fd_num(), &count, sizeof(count)));
+    register_read();
+}
@@ -0,0 +1,21 @@
+#ifndef SPONGE_LIBSPONGE_EVENTFD_HH
+#define SPONGE_LIBSPONGE_EVENTFD_HH
+
+#include "file_descriptor.hh"
+
+//! A FileDescriptor to a Linux [eventfd(2)](\ref man2::eventfd), used to wake up another thread
+class EventFD : public FileDescriptor {
+  public:
+    //! Create a new eventfd with its counter at zero
+    EventFD();
+
+    //! Increment the counter, making the eventfd readable (i.e., wake up a waiter or a poll)
+    //! \note Safe to call from several threads at once; unlike write(), it is not counted in write_count().
+    void notify();
+
+    //! Reset the counter to zero, blocking first until it is non-zero
+    //! \note Counts as a read of the fd, so it can be used from an EventLoop callback.
+    void wait();
+};
+
+#endif  // SPONGE_LIBSPONGE_EVENTFD_HH
@@ -74,6 +74,26 @@ string FileDescriptor::read(const size_t limit) {
     return ret;
 }
 
+//! \param[in] iovecs describes the memory to read into; fewer bytes than its total length may be read
+size_t FileDescriptor::read(const vector<iovec> &iovecs) {
+    size_t size_to_read = 0;
+    for (const auto &x : iovecs) {
+        size_to_read += x.iov_len;
+    }
+
+    const ssize_t bytes_read = SystemCall("readv", ::readv(fd_num(), iovecs.data(), iovecs.size()));
+    if (size_to_read > 0 && bytes_read == 0) {
+        _internal_fd->_eof = true;
+    }
+    if (bytes_read > static_cast<ssize_t>(size_to_read)) {
+        throw runtime_error("readv() read more than requested");
+    }
+
+    register_read();
+
+    return bytes_read;
+}
+
 size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
     size_t total_bytes_written = 0;
 
@@ -67,6 +67,10 @@ class FileDescriptor {
     //! Read up to `limit` bytes into `str` (caller can allocate storage)
     void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
 
+    //! Read into caller-provided memory with a single [readv(2)](\ref man2::readv)
+    //! \returns the number of bytes read (at most the total length of `iovecs`)
+    size_t read(const std::vector<iovec> &iovecs);
+
     //! Write a string, possibly blocking until all is written
     //char*类型的重载
     size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
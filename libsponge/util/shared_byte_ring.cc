@@ -0,0 +1,54 @@
+#include "shared_byte_ring.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+//! \param[in] capacity is the maximum number of bytes the ring holds at once
+SharedByteRing::SharedByteRing(const size_t capacity)
+    : _buf(round_up_pow2(capacity)), _mask(_buf.size() - 1), _capacity(capacity) {}
+
+size_t SharedByteRing::write(string_view data) {
+    // the acquire on _bytes_read makes sure the consumer is done with the space we are about to reuse
+    const size_t written = _bytes_written.load(memory_order_relaxed);
+    const size_t free_space = _capacity - (written - _bytes_read.load(memory_order_acquire));
+    const size_t len = min(data.size(), free_space);
+
+    const size_t pos = written & _mask;
+    const size_t first = min(len, _buf.size() - pos);
+    memcpy(_buf.data() + pos, data.data(), first);
+    memcpy(_buf.data(), data.data() + first, len - first);
+
+    // publish the bytes only after they have been copied in
+    _bytes_written.store(written + len, memory_order_release);
+    return len;
+}
+
+size_t SharedByteRing::remaining_capacity() const {
+    return _capacity - (_bytes_written.load(memory_order_relaxed) - _bytes_read.load(memory_order_acquire));
+}
+
+string_view SharedByteRing::peek() const {
+    const size_t read = _bytes_read.load(memory_order_relaxed);
+    const size_t len = _bytes_written.load(memory_order_acquire) - read;
+    const size_t pos = read & _mask;
+    return {_buf.data() + pos, min(len, _buf.size() - pos)};
+}
+
+void SharedByteRing::pop(const size_t len) {
+    const size_t read = _bytes_read.load(memory_order_relaxed);
+    const size_t count = min(len, _bytes_written.load(memory_order_acquire) - read);
+    _bytes_read.store(read + count, memory_order_release);
+}
+
+size_t SharedByteRing::buffer_size() const {
+    return _bytes_written.load(memory_order_acquire) - _bytes_read.load(memory_order_relaxed);
+}
+
+bool SharedByteRing::eof() const {
+    // check the flag first: once it is set, every byte the producer wrote is already visible
+    return _input_ended.load(memory_order_acquire) and buffer_size() == 0;
+}
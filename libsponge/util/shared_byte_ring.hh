@@ -0,0 +1,70 @@
+#ifndef SPONGE_LIBSPONGE_SHARED_BYTE_RING_HH
+#define SPONGE_LIBSPONGE_SHARED_BYTE_RING_HH
+
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+//! \brief A lock-free byte ring shared by exactly one producer thread and one consumer thread
+
+//! The producer calls write() and end_input(); the consumer calls peek(), pop() and end_output().
+//! Neither side ever blocks or takes a lock: the two threads only communicate through the
+//! monotonically increasing read and write counters. Pair it with an EventFD to sleep until
+//! the other side has made progress.
+class SharedByteRing {
+  private:
+    std::vector<char> _buf;  //环形缓冲区,长度为不小于capacity的2的幂
+    size_t _mask;            //_buf.size() - 1
+    size_t _capacity;
+
+    //读写计数器分别只由consumer和producer修改,放在不同的cache line上避免false sharing
+    alignas(64) std::atomic<size_t> _bytes_read{0};
+    alignas(64) std::atomic<size_t> _bytes_written{0};
+
+    std::atomic<bool> _input_ended{false};   //producer不会再写了
+    std::atomic<bool> _output_ended{false};  //consumer不会再读了
+
+  public:
+    //! Construct a ring with room for `capacity` bytes
+    explicit SharedByteRing(const size_t capacity);
+
+    //! \name Producer side
+    //!@{
+
+    //! Copy as much of `data` as fits into the ring
+    //! \returns the number of bytes accepted
+    size_t write(std::string_view data);
+
+    //! \returns the number of additional bytes that the ring has space for
+    size_t remaining_capacity() const;
+
+    //! Signal that no more bytes will be written
+    void end_input() { _input_ended.store(true, std::memory_order_release); }
+
+    //! \returns `true` if the consumer has stopped reading (writes will never drain)
+    bool output_ended() const { return _output_ended.load(std::memory_order_acquire); }
+    //!@}
+
+    //! \name Consumer side
+    //!@{
+
+    //! \returns a view of the readable bytes that are contiguous in memory (possibly not all of them)
+    //! \note The view stays valid until the matching pop()
+    std::string_view peek() const;
+
+    //! Remove `len` readable bytes, making room for the producer
+    void pop(const size_t len);
+
+    //! \returns the number of readable bytes
+    size_t buffer_size() const;
+
+    //! \returns `true` if the producer has ended the input and every byte has been popped
+    bool eof() const;
+
+    //! Signal that no more bytes will be read
+    void end_output() { _output_ended.store(true, std::memory_order_release); }
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_SHARED_BYTE_RING_HH
@@ -55,6 +55,14 @@ int SystemCall(const string &attempt, const int return_value, const int errno_ma
     return SystemCall(attempt.c_str(), return_value, errno_mask);
 }
 
+size_t round_up_pow2(const size_t n) {
+    size_t ret = 1;
+    while (ret < n) {
+        ret <<= 1;
+    }
+    return ret;
+}
+
 //! \details A properly seeded mt19937 generator takes a lot of entropy!
 //!
 //! This code borrows from the following:
@@ -0,0 +1,62 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        for (const bool chunked : {false, true}) {
+            ByteStreamTestHarness test{"write-buffer-overwrite", 5, chunked};
+
+            test.execute(WriteBuffer{"abc"}.with_bytes_written(3));
+            test.execute(WriteBuffer{"defg"}.with_bytes_written(2));
+            test.execute(WriteBuffer{"h"}.with_bytes_written(0));
+
+            test.execute(BytesWritten{5});
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferSize{5});
+            test.execute(Peek{"abcde"});
+
+            test.execute(ReadBuffers{2, "ab"});
+            test.execute(Write{"xyz"}.with_bytes_written(2));
+            test.execute(Peek{"cdexy"});
+
+            test.execute(ReadBuffers{10, "cdexy"});
+            test.execute(BufferEmpty{true});
+            test.execute(BytesRead{7});
+            test.execute(BytesWritten{7});
+            test.execute(RemainingCapacity{5});
+            test.execute(EndInput{});
+            test.execute(Eof{true});
+        }
+
+        {
+            ByteStreamTestHarness test{"chunked-split-across-buffers", 15, true};
+
+            test.execute(WriteBuffer{"hello"});
+            test.execute(WriteBuffer{"world"});
+            test.execute(Write{"!"});
+
+            test.execute(BufferSize{11});
+            test.execute(Peek{"hellowo"});
+            test.execute(Pop{3});
+            test.execute(ReadBuffers{4, "lowo"});
+            test.execute(Peek{"rld!"});
+            test.execute(Pop{2});
+            test.execute(ReadBuffers{2, "d!"});
+
+            test.execute(BufferEmpty{true});
+            test.execute(BytesRead{11});
+            test.execute(RemainingCapacity{15});
+        }
+
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
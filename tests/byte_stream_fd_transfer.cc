@@ -0,0 +1,78 @@
+#include "byte_stream.hh"
+#include "file_descriptor.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <climits>
+#include <exception>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+
+static pair<FileDescriptor, FileDescriptor> make_pipe() {
+    int fds[2];
+    SystemCall("pipe", ::pipe(static_cast<int *>(fds)));
+    return {FileDescriptor(fds[0]), FileDescriptor(fds[1])};
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t CAPACITY = 5000;
+
+        for (const bool chunked : {false, true}) {
+            auto [in_rd, in_wr] = make_pipe();
+            auto [out_rd, out_wr] = make_pipe();
+            ByteStream bs{CAPACITY, chunked};
+
+            string data(20000, 0);
+            generate(data.begin(), data.end(), [&] { return 'a' + (rd() % 26); });
+            in_wr.write(data);
+            in_wr.close();
+
+            // move bytes pipe -> stream -> pipe in odd-sized steps so the ring wraps many times
+            string received;
+            while (received.size() < data.size()) {
+                const size_t before = bs.buffer_size();
+                const size_t n_in = bs.read_from(in_rd, 1 + rd() % 3000);
+                test_err_if(bs.buffer_size() != before + n_in, "read_from() miscounted the bytes it read");
+                test_err_if(bs.buffer_size() > CAPACITY, "read_from() overfilled the stream");
+
+                const size_t n_out = bs.write_to(out_wr, 1 + rd() % 3000);
+                received += out_rd.read(n_out);
+                test_err_if(received != data.substr(0, received.size()), "bytes came out of the stream out of order");
+            }
+
+            test_err_if(bs.read_from(in_rd) != 0, "read_from() returned data after the end of the pipe");
+            test_err_if(not in_rd.eof(), "read_from() did not record EOF on the file descriptor");
+            test_err_if(bs.bytes_written() != data.size(), "bytes_written() is wrong");
+            test_err_if(bs.bytes_read() != data.size(), "bytes_read() is wrong");
+            test_err_if(not bs.buffer_empty(), "the stream should be empty");
+        }
+
+        // more one-byte chunks than writev accepts at once (IOV_MAX): write_to must not fail with EINVAL
+        {
+            auto [out_rd, out_wr] = make_pipe();
+            ByteStream bs{CAPACITY, true};
+            string data(3 * IOV_MAX, 0);
+            generate(data.begin(), data.end(), [&] { return 'a' + (rd() % 26); });
+            for (const char c : data) {
+                test_err_if(bs.write(Buffer(string(1, c))) != 1, "write() did not accept a one-byte chunk");
+            }
+
+            string received;
+            while (not bs.buffer_empty()) {
+                const size_t n_out = bs.write_to(out_wr);
+                test_err_if(n_out == 0 or n_out > IOV_MAX, "write_to() wrote the wrong number of chunks");
+                received += out_rd.read(n_out);
+            }
+            test_err_if(received != data, "one-byte chunks came out of the stream corrupted or out of order");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
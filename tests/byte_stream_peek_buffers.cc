@@ -0,0 +1,68 @@
+#include "byte_stream.hh"
+#include "file_descriptor.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+
+// Drain `bs` into a small non-blocking pipe with peek_buffers() + pop_output(),
+// so that every writev is partial, and check that the bytes come out in order.
+static void drain_through_pipe(ByteStream &bs, const string &expected) {
+    int fds[2];
+    SystemCall("pipe", ::pipe(static_cast<int *>(fds)));
+    FileDescriptor rd{fds[0]}, wr{fds[1]};
+    SystemCall("fcntl", ::fcntl(wr.fd_num(), F_SETPIPE_SZ, 4096));
+    wr.set_blocking(false);
+
+    string received;
+    while (not bs.buffer_empty()) {
+        const auto views = bs.peek_buffers(bs.buffer_size());
+        test_err_if(views.size() != bs.buffer_size(), "peek_buffers() returned the wrong number of bytes");
+
+        const size_t bytes_written = wr.write(views, false);
+        test_err_if(bytes_written == 0, "write to an empty pipe made no progress");
+        bs.pop_output(bytes_written);
+
+        received += rd.read(bytes_written);
+        test_err_if(received != expected.substr(0, received.size()), "bytes came out of the pipe out of order");
+    }
+    test_err_if(received != expected, "not every byte made it through the pipe");
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t CAPACITY = 10000;
+
+        for (const bool chunked : {false, true}) {
+            ByteStream bs{CAPACITY, chunked};
+
+            string first(9000, 0), second(9000, 0);
+            generate(first.begin(), first.end(), [&] { return 'a' + (rd() % 26); });
+            generate(second.begin(), second.end(), [&] { return 'a' + (rd() % 26); });
+
+            // move the read position near the end of the ring so the next write wraps around
+            test_err_if(bs.write(first) != first.size(), "write() did not accept the first string");
+            bs.pop_output(8000);
+            test_err_if(bs.write(second) != 9000, "write() did not accept the second string");
+
+            // a partial peek must not disturb the stream
+            test_err_if(bs.peek_buffers(100).size() != 100, "peek_buffers(100) did not return 100 bytes");
+            test_err_if(bs.buffer_size() != CAPACITY, "peek_buffers() changed the buffer size");
+
+            drain_through_pipe(bs, first.substr(8000) + second);
+            test_err_if(bs.bytes_read() != 18000, "bytes_read() is wrong after draining");
+            test_err_if(bs.remaining_capacity() != CAPACITY, "remaining_capacity() is wrong after draining");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -45,11 +45,11 @@ void ByteStreamAction::execute(ByteStream &) const {}
 
 ByteStreamAction::~ByteStreamAction() {}
 
-ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity, const bool chunked)
+    : _test_name(test_name), _byte_stream(capacity, chunked) {
     std::ostringstream ss;
     ss << "Initialized with ("
-       << "capacity=" << capacity << ")";
+       << "capacity=" << capacity << ", chunked=" << chunked << ")";
     _steps_executed.emplace_back(ss.str());
 }
 
@@ -97,6 +97,33 @@ void Write::execute(ByteStream &bs) const {
     }
 }
 
+// WriteBuffer
+WriteBuffer::WriteBuffer(const std::string &data) : _data(data) {}
+WriteBuffer &WriteBuffer::with_bytes_written(const size_t bytes_written) {
+    _bytes_written = bytes_written;
+    return *this;
+}
+std::string WriteBuffer::description() const { return "write Buffer \"" + _data + "\" to the stream"; }
+void WriteBuffer::execute(ByteStream &bs) const {
+    auto bytes_written = bs.write(Buffer(string(_data)));
+    if (_bytes_written and bytes_written != _bytes_written.value()) {
+        throw ByteStreamExpectationViolation::property("bytes_written", _bytes_written.value(), bytes_written);
+    }
+}
+
+// ReadBuffers
+ReadBuffers::ReadBuffers(const size_t len, const std::string &output) : _len(len), _output(output) {}
+std::string ReadBuffers::description() const {
+    return "read_buffers " + to_string(_len) + " (expecting \"" + _output + "\")";
+}
+void ReadBuffers::execute(ByteStream &bs) const {
+    auto output = bs.read_buffers(_len).concatenate();
+    if (output != _output) {
+        throw ByteStreamExpectationViolation("Expected read_buffers to return \"" + _output + "\", but found \"" +
+                                             output + "\"");
+    }
+}
+
 // Pop
 Pop::Pop(const size_t len) : _len(len) {}
 std::string Pop::description() const { return "pop " + to_string(_len); }
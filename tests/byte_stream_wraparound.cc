@@ -0,0 +1,89 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"wraparound-small", 5};
+
+            test.execute(Write{"abcde"}.with_bytes_written(5));
+            test.execute(Pop{3});
+            test.execute(Write{"fgh"}.with_bytes_written(3));
+
+            test.execute(BytesRead{3});
+            test.execute(BytesWritten{8});
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferSize{5});
+            test.execute(Peek{"defgh"});
+
+            test.execute(Pop{4});
+            test.execute(Write{"ijklmn"}.with_bytes_written(4));
+            test.execute(Peek{"hijkl"});
+
+            test.execute(Pop{5});
+            test.execute(BufferEmpty{true});
+            test.execute(BytesRead{12});
+            test.execute(BytesWritten{12});
+            test.execute(RemainingCapacity{5});
+        }
+
+        {
+            ByteStreamTestHarness test{"zero-capacity", 0};
+
+            test.execute(Write{"cat"}.with_bytes_written(0));
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferEmpty{true});
+            test.execute(Peek{""});
+            test.execute(EndInput{});
+            test.execute(Eof{true});
+        }
+
+        {
+            auto rd = get_random_generator();
+            const size_t NREPS = 2000;
+            const size_t CAPACITY = 1000;
+
+            ByteStreamTestHarness test{"wraparound-random", CAPACITY};
+
+            // keep a mirror of the expected contents and check it against the stream after every
+            // write and pop, so that every offset of the ring buffer gets crossed many times
+            string expected;
+            size_t written = 0, read = 0;
+            for (size_t i = 0; i < NREPS; ++i) {
+                const size_t size = rd() % (CAPACITY + 1);
+                string d(size, 0);
+                generate(d.begin(), d.end(), [&] { return 'a' + (rd() % 26); });
+
+                const size_t accepted = min(size, CAPACITY - expected.size());
+                test.execute(Write{d}.with_bytes_written(accepted));
+                expected += d.substr(0, accepted);
+                written += accepted;
+
+                test.execute(BufferSize{expected.size()});
+                test.execute(RemainingCapacity{CAPACITY - expected.size()});
+                test.execute(Peek{expected});
+
+                const size_t to_pop = rd() % (expected.size() + 1);
+                test.execute(Pop{to_pop});
+                expected = expected.substr(to_pop);
+                read += to_pop;
+
+                test.execute(BytesWritten{written});
+                test.execute(BytesRead{read});
+                test.execute(Peek{expected});
+            }
+        }
+
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//让连接开始时快速确认的段都过去,seqno是对方下一个字节的序号
+static void skip_quickacks(TCPTestHarness &test, WrappingInt32 &seqno, const WrappingInt32 isn, const string &name) {
+    for (unsigned i = 0; i < TCPConfig::QUICKACK_SEGMENTS; i++) {
+        test.send_byte(seqno, isn + 1, 'q');
+        seqno = seqno + 1;
+        test.execute(ExpectOneSegment{}.with_ackno(seqno),
+                     name + " failed: segment at the start was not ACKed at once");
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.delayed_ack = true;
+
+        // test 1: in-order data is ACKed every second segment or after the delay; other segments at once
+        {
+            const WrappingInt32 isn(rd()), rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, isn, rx_isn);
+            WrappingInt32 seqno = rx_isn + 1;
+            skip_quickacks(test_1, seqno, isn, "test 1");
+
+            test_1.send_byte(seqno, isn + 1, 'a');
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: first segment was ACKed at once");
+            test_1.send_byte(seqno + 1, isn + 1, 'b');
+            test_1.execute(ExpectOneSegment{}.with_ackno(seqno + 2), "test 1 failed: second segment was not ACKed");
+            seqno = seqno + 2;
+
+            test_1.send_byte(seqno, isn + 1, 'c');
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: segment was ACKed at once");
+            test_1.execute(Tick(cfg.delayed_ack_ms - 1));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: ACK was sent before the delay");
+            test_1.execute(Tick(1));
+            test_1.execute(ExpectOneSegment{}.with_ackno(seqno + 1), "test 1 failed: delayed ACK was not sent");
+            seqno = seqno + 1;
+
+            // a gap and the segment that fills it are ACKed at once
+            test_1.send_byte(seqno + 1, isn + 1, 'e');
+            test_1.execute(ExpectOneSegment{}.with_ackno(seqno), "test 1 failed: out-of-order data was not ACKed");
+            test_1.send_byte(seqno, isn + 1, 'd');
+            test_1.execute(ExpectOneSegment{}.with_ackno(seqno + 2), "test 1 failed: filled gap was not ACKed");
+            seqno = seqno + 2;
+
+            // outgoing data carries the delayed ACK
+            test_1.send_byte(seqno, isn + 1, 'f');
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: segment was ACKed at once");
+            test_1.execute(Write{"x"});
+            test_1.execute(ExpectOneSegment{}.with_data("x").with_ackno(seqno + 1),
+                           "test 1 failed: data did not carry the ACK");
+            test_1.execute(Tick(cfg.delayed_ack_ms));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: ACK was sent twice");
+            seqno = seqno + 1;
+
+            test_1.send_fin(seqno, isn + 2);
+            test_1.execute(ExpectOneSegment{}.with_ackno(seqno + 1), "test 1 failed: FIN was not ACKed at once");
+        }
+
+        // test 2: quick-ACK mode ACKs every segment, and sends the ACK that is being delayed
+        {
+            const WrappingInt32 isn(rd()), rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, isn, rx_isn);
+            WrappingInt32 seqno = rx_isn + 1;
+            skip_quickacks(test_2, seqno, isn, "test 2");
+
+            test_2.send_byte(seqno, isn + 1, 'a');
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: segment was ACKed at once");
+            test_2.execute(SetQuickAck{true});
+            test_2.execute(ExpectOneSegment{}.with_ackno(seqno + 1), "test 2 failed: delayed ACK was not sent");
+            test_2.send_byte(seqno + 1, isn + 1, 'b');
+            test_2.execute(ExpectOneSegment{}.with_ackno(seqno + 2), "test 2 failed: quick-ACK mode delayed");
+
+            test_2.execute(SetQuickAck{false});
+            test_2.send_byte(seqno + 2, isn + 1, 'c');
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: segment was ACKed at once");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
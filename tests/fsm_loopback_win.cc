@@ -24,6 +24,9 @@ int main() {
     try {
         TCPConfig cfg{};
         cfg.recv_capacity = 65000;
+        // all 65000 bytes are sent before the first ACK comes back, which is more than NewReno's initial
+        // window of ten segments; only the receiver's window is under test here
+        cfg.congestion_control = CongestionControl::Algorithm::None;
         auto rd = get_random_generator();
 
         // loop segments back in a different order
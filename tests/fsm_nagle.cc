@@ -0,0 +1,101 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: Nagle holds partial segments while data is in flight
+        {
+            TCPConfig cfg{};
+            cfg.nagle = true;
+            const WrappingInt32 isn(rd()), seq_base(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, isn, seq_base);
+            test_1.send_ack(seq_base + 1, isn + 1, 10000);
+
+            // nothing in flight: the first small write goes out at once
+            test_1.execute(Write{"a"});
+            test_1.execute(ExpectOneSegment{}.with_data("a"), "test 1 failed: first write was held");
+            test_1.execute(Write{"b"});
+            test_1.execute(Write{"c"});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: small write was sent with data in flight");
+
+            // the ACK releases everything written meanwhile as one segment
+            test_1.send_ack(seq_base + 1, isn + 2, 10000);
+            test_1.execute(ExpectOneSegment{}.with_data("bc"), "test 1 failed: held data was not coalesced");
+
+            // a full segment does not wait
+            test_1.execute(Write{string(MSS, 'x')});
+            test_1.execute(ExpectOneSegment{}.with_payload_size(MSS), "test 1 failed: full segment was held");
+
+            test_1.execute(Write{"d"});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: small write was sent with data in flight");
+            test_1.execute(Flush{});
+            test_1.execute(ExpectOneSegment{}.with_data("d"), "test 1 failed: flush did not send held data");
+
+            // the end of the stream sends the rest with the FIN
+            test_1.execute(Write{"e"});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: small write was sent with data in flight");
+            test_1.execute(Close{});
+            test_1.execute(ExpectOneSegment{}.with_data("e").with_fin(true), "test 1 failed: close did not send");
+        }
+
+        // test 2: a corked connection holds partial segments even with nothing in flight
+        {
+            TCPConfig cfg{};
+            cfg.cork = true;
+            const WrappingInt32 isn(rd()), seq_base(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, isn, seq_base);
+            test_2.send_ack(seq_base + 1, isn + 1, 10000);
+
+            test_2.execute(Write{"hello"});
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: corked data was sent");
+            test_2.execute(Tick(TCPConfig::CORK_TIMEOUT_MS - 1));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: corked data was sent before the timeout");
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_data("hello"), "test 2 failed: cork did not time out");
+
+            test_2.execute(Write{"abc"});
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: corked data was sent");
+            test_2.execute(SetCork{false});
+            test_2.execute(ExpectOneSegment{}.with_data("abc"), "test 2 failed: uncorking did not send");
+
+            // full segments go out while corked; only the partial tail waits
+            test_2.execute(SetCork{true});
+            test_2.execute(Write{string(MSS + 3, 'y')});
+            test_2.execute(ExpectOneSegment{}.with_payload_size(MSS), "test 2 failed: full segment was held");
+            test_2.execute(Flush{});
+            test_2.execute(ExpectOneSegment{}.with_data("yyy"), "test 2 failed: flush did not send the tail");
+        }
+
+        // test 3: without Nagle or the cork every write is sent right away
+        {
+            const WrappingInt32 isn(rd()), seq_base(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(TCPConfig{}, isn, seq_base);
+
+            test_3.execute(Write{"a"});
+            test_3.execute(ExpectOneSegment{}.with_data("a"), "test 3 failed: write was held");
+            test_3.execute(Write{"b"});
+            test_3.execute(ExpectOneSegment{}.with_data("b"), "test 3 failed: write was held");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr unsigned NREPS = 8;
+static constexpr size_t STREAM_LEN = 16384;
+static constexpr size_t CAPACITY = 4096;
+static constexpr size_t MAX_FRAGMENTS = 64;
+static constexpr size_t RETX_LEN = 512;
+
+// An abusive peer: mostly 1-byte and tiny overlapping or duplicated segments scattered over the
+// window, with an occasional well-behaved retransmission from the next expected byte.
+void run(const bool windowed, mt19937 &rd) {
+    string d(STREAM_LEN, 0);
+    generate(d.begin(), d.end(), [&] { return rd(); });
+
+    StreamReassembler buf{CAPACITY, false, windowed};
+    buf.set_max_fragments(MAX_FRAGMENTS);
+
+    string result;
+    size_t pushes = 0;
+    while (not buf.stream_out().eof()) {
+        const size_t next = buf.stream_out().bytes_written();
+        if (++pushes > 64 * STREAM_LEN) {
+            throw runtime_error("stream stalled at byte " + to_string(next));
+        }
+
+        size_t off, len;
+        if (rd() % 256 == 0) {
+            off = next;
+            len = min(RETX_LEN, STREAM_LEN - off);
+        } else {
+            // anywhere from a little behind the next expected byte to a little past the window
+            off = min(STREAM_LEN - 1, next + rd() % (CAPACITY + 256) - min<size_t>(next, 128));
+            len = min<size_t>(rd() % 4 == 0 ? 1 + rd() % 8 : 1, STREAM_LEN - off);
+        }
+        buf.push_substring(d.substr(off, len), off, off + len == STREAM_LEN);
+
+        if (buf.fragments() > MAX_FRAGMENTS) {
+            throw runtime_error("reassembler holds " + to_string(buf.fragments()) + " fragments");
+        }
+        if (buf.unassembled_bytes() + buf.stream_out().buffer_size() > CAPACITY) {
+            throw runtime_error("reassembler holds more than its capacity");
+        }
+
+        // the reader keeps up, but not always completely
+        ByteStream &out = buf.stream_out();
+        result += out.read(rd() % 2 ? out.buffer_size() : out.buffer_size() / 2);
+    }
+    result += buf.stream_out().read(buf.stream_out().buffer_size());
+
+    if (result != d) {
+        throw runtime_error(string(windowed ? "window" : "interval") + " engine reassembled the wrong bytes");
+    }
+    if (not windowed and buf.dropped_fragments() == 0) {
+        throw runtime_error("expected the fragment limit to be reached");
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            run(false, rd);
+            run(true, rd);
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
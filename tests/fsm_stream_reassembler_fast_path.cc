@@ -0,0 +1,76 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        for (const bool windowed : {false, true}) {
+            // in-order segments go straight to the stream, including ones that overlap what was already written
+            {
+                ReassemblerTestHarness test{65000, windowed};
+
+                test.execute(SubmitSegment{"abcd", 0});
+                test.execute(SubmitSegment{"cdef", 2});
+                test.execute(SubmitSegment{"abcdefgh", 0});
+                test.execute(InOrderPushes(3));
+                test.execute(UnassembledBytes(0));
+                test.execute(BytesAvailable("abcdefgh"));
+
+                // a pure duplicate and an empty segment write nothing
+                test.execute(SubmitSegment{"abc", 0});
+                test.execute(SubmitSegment{"", 8});
+                test.execute(InOrderPushes(3));
+                test.execute(BytesAssembled(8));
+            }
+
+            // once there is a hole, in-order data goes through the out-of-order store until it is filled
+            {
+                ReassemblerTestHarness test{65000, windowed};
+
+                test.execute(SubmitSegment{"ghi", 6});
+                test.execute(SubmitSegment{"abc", 0});
+                test.execute(InOrderPushes(0));
+                test.execute(BytesAvailable("abc"));
+                test.execute(UnassembledBytes(3));
+
+                test.execute(SubmitSegment{"def", 3});
+                test.execute(InOrderPushes(0));
+                test.execute(UnassembledBytes(0));
+                test.execute(BytesAvailable("defghi"));
+
+                test.execute(SubmitSegment{"jkl", 9}.with_eof(true));
+                test.execute(InOrderPushes(1));
+                test.execute(BytesAvailable("jkl"));
+                test.execute(AtEof{});
+            }
+
+            // the part of an in-order segment that does not fit is dropped, and the eof waits for it
+            {
+                ReassemblerTestHarness test{4, windowed};
+
+                test.execute(SubmitSegment{"abcdef", 0}.with_eof(true));
+                test.execute(InOrderPushes(1));
+                test.execute(BytesAssembled(4));
+                test.execute(UnassembledBytes(0));
+                test.execute(BytesAvailable("abcd"));
+                test.execute(NotAtEof{});
+
+                test.execute(SubmitSegment{"cdef", 2}.with_eof(true));
+                test.execute(InOrderPushes(2));
+                test.execute(BytesAvailable("ef"));
+                test.execute(AtEof{});
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
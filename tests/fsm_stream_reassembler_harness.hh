@@ -103,6 +103,26 @@ struct UnassembledBytes : public ReassemblerExpectation {
     }
 };
 
+struct InOrderPushes : public ReassemblerExpectation {
+    size_t _pushes;
+
+    InOrderPushes(size_t pushes) : _pushes(pushes) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "pushes that took the in-order fast path = " << _pushes;
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        if (reassembler.in_order_pushes() != _pushes) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to have written `" << _pushes
+               << "` pushes straight to the stream, but there were `" << reassembler.in_order_pushes() << "`";
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct AtEof : public ReassemblerExpectation {
     AtEof() {}
     std::string description() const {
@@ -164,8 +184,10 @@ class ReassemblerTestHarness {
     std::vector<std::string> steps_executed;
 
   public:
-    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity), steps_executed() {
-        steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ")");
+    ReassemblerTestHarness(const size_t capacity, const bool windowed = false)
+        : reassembler(capacity, false, windowed), steps_executed() {
+        steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) +
+                                    ", windowed = " + std::to_string(windowed) + ")");
     }
 
     void execute(const ReassemblerTestStep &step) {
@@ -0,0 +1,142 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+static constexpr unsigned NREPS = 64;
+static constexpr unsigned NSEGS = 256;
+static constexpr unsigned MAX_SEG_LEN = 300;
+
+int main() {
+    try {
+        // capacity limits, as in fsm_stream_reassembler_cap
+        {
+            ReassemblerTestHarness test{2, true};
+
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(BytesAssembled(2));
+
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(BytesAssembled(2));
+
+            test.execute(BytesAvailable("ab"));
+            test.execute(SubmitSegment{"bcdef", 1});
+            test.execute(BytesAssembled(4));
+            test.execute(BytesAvailable("cd"));
+            test.execute(NotAtEof{});
+        }
+
+        // holes and overlaps inside one bitmap word, then across words
+        {
+            ReassemblerTestHarness test{200, true};
+
+            test.execute(SubmitSegment{"b", 1});
+            test.execute(SubmitSegment{"d", 3});
+            test.execute(UnassembledBytes(2));
+            test.execute(BytesAssembled(0));
+
+            test.execute(SubmitSegment{"abc", 0});
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("abcd"));
+
+            test.execute(SubmitSegment{string(100, 'y'), 70});
+            test.execute(SubmitSegment{string(70, 'x'), 60});
+            test.execute(UnassembledBytes(110));
+            test.execute(SubmitSegment{string(56, 'w'), 4});
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable(string(56, 'w') + string(70, 'x') + string(40, 'y')));
+
+            test.execute(SubmitSegment{"z", 170}.with_eof(true));
+            test.execute(BytesAvailable("z"));
+            test.execute(AtEof{});
+        }
+
+        // a gap closes in front of whole bitmap words that are already full
+        {
+            ReassemblerTestHarness test{256, true};
+
+            test.execute(SubmitSegment{string(63, 'b'), 1});
+            test.execute(SubmitSegment{string(128, 'c'), 64});
+            test.execute(UnassembledBytes(191));
+            test.execute(BytesAssembled(0));
+
+            test.execute(SubmitSegment{"a", 0});
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAvailable("a" + string(63, 'b') + string(128, 'c')));
+
+            // the next run starts on a word boundary and spans more than one word
+            test.execute(SubmitSegment{string(64, 'e'), 193});
+            test.execute(SubmitSegment{string(1, 'd'), 192});
+            test.execute(BytesAvailable("d" + string(64, 'e')));
+        }
+
+        // many passes around a window that is exactly one bitmap word
+        {
+            ReassemblerTestHarness test{64, true};
+            for (unsigned i = 0; i < 20; ++i) {
+                const string data = to_string(1000 + i) + string(36, 'a' + i);
+                test.execute(SubmitSegment{data.substr(20), i * 40 + 20});
+                test.execute(SubmitSegment{data.substr(0, 25), i * 40});
+                test.execute(BytesAvailable(string(data)));
+            }
+        }
+
+        // the window engine must produce the same stream as the interval engine
+        auto rd = get_random_generator();
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            const size_t capacity = 1 + rd() % (4 * MAX_SEG_LEN);
+            StreamReassembler interval{capacity};
+            StreamReassembler window{capacity, false, true};
+
+            vector<tuple<size_t, size_t>> seq_size;
+            size_t offset = 0;
+            for (unsigned i = 0; i < NSEGS; ++i) {
+                const size_t size = 1 + rd() % MAX_SEG_LEN;
+                const size_t offs = min<size_t>(offset, rd() % 64);
+                seq_size.emplace_back(offset - offs, size + offs);
+                offset += size;
+            }
+            // shuffle within small groups so that most segments still land inside the window
+            for (auto it = seq_size.begin(); it < seq_size.end(); it += 8) {
+                shuffle(it, min(it + 8, seq_size.end()), rd);
+            }
+
+            string d(offset, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+
+            string out_interval, out_window;
+            for (unsigned pass = 0; pass < 4 and out_window.size() < offset; ++pass) {
+                for (auto [off, sz] : seq_size) {
+                    const string dd = d.substr(off, sz);
+                    interval.push_substring(dd, off, off + sz == offset);
+                    window.push_substring(dd, off, off + sz == offset);
+                    if (interval.unassembled_bytes() != window.unassembled_bytes()) {
+                        throw runtime_error("unassembled_bytes differs between engines");
+                    }
+                    ByteStream &in = interval.stream_out(), &wn = window.stream_out();
+                    out_interval += in.read(min<size_t>(rd() % (2 * MAX_SEG_LEN), in.buffer_size()));
+                    out_window += wn.read(min(out_interval.size() - out_window.size(), wn.buffer_size()));
+                }
+            }
+            if (out_window != out_interval or out_window != d.substr(0, out_window.size())) {
+                throw runtime_error("window engine produced the wrong bytes");
+            }
+            if (interval.stream_out().input_ended() != window.stream_out().input_ended()) {
+                throw runtime_error("window engine disagrees about eof");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+#include "emulated_link.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//两个连接之间隔着5ms的单向时延和500字节/ms的瓶颈,接收方的应用每ms只读read_rate个字节.
+//返回发送方发出的数据段的个数
+static size_t slow_reader_segments(const bool sws_avoidance, const size_t len, const size_t read_rate) {
+    TCPConfig config;
+    config.sws_avoidance = sws_avoidance;
+    config.recv_capacity = 8000;
+    TCPConnection x{config}, y{config};
+    //瓶颈把段一个个隔开,每个ack只能把窗口打开一点(应用在这期间读走的字节)
+    EmulatedLink forward{5, 500, 1000}, backward{5, 0, 1000};
+    string data(len, 'x');
+    size_t written = 0, received = 0, segments = 0;
+    x.connect();
+    y.end_input_stream();
+    for (uint64_t now = 0; not y.inbound_stream().eof(); ++now) {
+        if (now > 60 * 1000) {
+            throw runtime_error("the transfer to a slow reader did not finish");
+        }
+        if (written < len) {
+            written += x.write(data.substr(written));
+            if (written == len) {
+                x.end_input_stream();
+            }
+        }
+        forward.advance(now);
+        for (; not x.segments_out().empty(); x.segments_out().pop()) {
+            segments += x.segments_out().front().payload().size() > 0;
+            forward.push(x.segments_out().front());
+        }
+        while (auto seg = forward.pop()) {
+            y.segment_received(seg.value());
+        }
+        backward.advance(now);
+        for (; not y.segments_out().empty(); y.segments_out().pop()) {
+            backward.push(y.segments_out().front());
+        }
+        while (auto seg = backward.pop()) {
+            x.segment_received(seg.value());
+        }
+        received += y.inbound_stream().read(read_rate).size();
+        x.tick(1);
+        y.tick(1);
+    }
+    if (received != len) {
+        throw runtime_error("the slow reader got " + to_string(received) + " of " + to_string(len) + " bytes");
+    }
+    return segments;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: the sender holds back a segment cut short by the window while data is in flight
+        for (const bool sws_avoidance : {true, false}) {
+            TCPConfig cfg{};
+            cfg.sws_avoidance = sws_avoidance;
+            cfg.congestion_control = CongestionControl::Algorithm::None;
+            const WrappingInt32 isn(rd()), seq_base(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, isn, seq_base);
+            test_1.send_ack(seq_base + 1, isn + 1, 2 * MSS + 500);
+
+            test_1.execute(Write{string(4 * MSS, 'x')});
+            test_1.execute(ExpectSegment{}.with_payload_size(MSS), "test 1 failed: no full segment");
+            test_1.execute(ExpectSegment{}.with_payload_size(MSS), "test 1 failed: no full segment");
+            if (sws_avoidance) {
+                test_1.execute(ExpectNoSegment{}, "test 1 failed: a small segment went out with data in flight");
+            } else {
+                test_1.execute(ExpectOneSegment{}.with_payload_size(500), "test 1 failed: window was not filled");
+            }
+
+            // the window opens by one segment
+            test_1.send_ack(seq_base + 1, isn + 1 + MSS, 2 * MSS + 500);
+            test_1.execute(ExpectOneSegment{}.with_payload_size(MSS), "test 1 failed: no full segment");
+            test_1.send_ack(seq_base + 1, isn + 1 + 3 * MSS, 2 * MSS + 500);
+            test_1.execute(ExpectOneSegment{}.with_payload_size(sws_avoidance ? MSS : MSS - 500),
+                           "test 1 failed: the rest was not sent");
+
+            // data shorter than a segment is not held back for the window
+            test_1.execute(Write{"abc"});
+            test_1.execute(ExpectOneSegment{}.with_data("abc"), "test 1 failed: short write was held");
+        }
+
+        // test 2: the receiver holds small window updates back
+        for (const bool sws_avoidance : {true, false}) {
+            TCPConfig cfg{};
+            cfg.sws_avoidance = sws_avoidance;
+            cfg.recv_capacity = 4000;
+            const WrappingInt32 isn(rd()), seq_base(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, isn, seq_base);
+
+            const string data(4000, 'y');
+            test_2.send_data(seq_base + 1, isn + 1, data.cbegin(), data.cend());
+            test_2.execute(ExpectOneSegment{}.with_ackno(seq_base + 4001).with_win(0),
+                           "test 2 failed: the full window was not closed");
+
+            // the application reads 100 bytes; a probe is ACKed without opening the window by 99 bytes
+            test_2._fsm.inbound_stream().read(100);
+            test_2.send_byte(seq_base + 4001, isn + 1, 'z');
+            test_2.execute(ExpectOneSegment{}.with_ackno(seq_base + 4002).with_win(sws_avoidance ? 0 : 99),
+                           "test 2 failed: wrong window after a small read");
+
+            // the right edge can move by a full segment: the whole window opens
+            test_2._fsm.inbound_stream().read(1500);
+            test_2.send_byte(seq_base + 4002, isn + 1, 'z');
+            test_2.execute(ExpectOneSegment{}.with_ackno(seq_base + 4003).with_win(1598),
+                           "test 2 failed: the window did not open");
+        }
+
+        // test 3: a slow reader gets far fewer (and fuller) segments
+        {
+            const size_t with_sws = slow_reader_segments(true, 100000, 100);
+            const size_t without_sws = slow_reader_segments(false, 100000, 100);
+            if (with_sws * 3 > without_sws) {
+                cerr << "test 3 failed: " << with_sws << " segments with SWS avoidance, " << without_sws
+                     << " without" << endl;
+                return EXIT_FAILURE;
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.timestamps = true;
+
+        // test 1: timestamps are echoed, old segments are rejected (PAWS), and data leaves room for the option
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Listen{});
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(10000).with_timestamps(1000, 0));
+
+            TCPSegment syn_ack = test_1.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                   "test 1 failed: no SYN/ACK");
+            test_err_if(not syn_ack.header().timestamps.has_value() or syn_ack.header().timestamps->second != 1000,
+                        "test 1 failed: SYN/ACK did not echo the timestamp");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(10000)
+                               .with_timestamps(1010, 0));
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(10000)
+                               .with_timestamps(1020, 0)
+                               .with_data("abc"));
+            TCPSegment ack = test_1.expect_seg(ExpectOneSegment{}.with_ackno(seq_base + 4), "test 1 failed: no ACK");
+            test_err_if(not ack.header().timestamps.has_value() or ack.header().timestamps->second != 1020,
+                        "test 1 failed: ACK did not echo the latest timestamp");
+            test_1.execute(ExpectData{}.with_data("abc"));
+
+            // a segment with an older timestamp is a duplicate from before the sequence numbers wrapped:
+            // it is acknowledged but not accepted
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 4)
+                               .with_ackno(ack_base + 1)
+                               .with_win(10000)
+                               .with_timestamps(1015, 0)
+                               .with_data("old"));
+            test_1.execute(ExpectOneSegment{}.with_ackno(seq_base + 4).with_payload_size(0),
+                           "test 1 failed: old segment was not answered with an ACK");
+            test_err_if(test_1._fsm.inbound_stream().buffer_size() != 0, "test 1 failed: PAWS accepted old data");
+            test_1.execute(ExpectUnassembledBytes{0});
+
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 4)
+                               .with_ackno(ack_base + 1)
+                               .with_win(10000)
+                               .with_timestamps(1030, 0)
+                               .with_data("new"));
+            test_1.execute(ExpectOneSegment{}.with_ackno(seq_base + 7), "test 1 failed: new data was not ACKed");
+            test_1.execute(ExpectData{}.with_data("new"));
+
+            // every data segment carries the option, so full segments are shorter
+            test_1.execute(Write{string(2 * TCPConfig::MAX_PAYLOAD_SIZE, 'x')});
+            test_1.execute(Tick(1));
+            TCPSegment data = test_1.expect_seg(
+                ExpectSegment{}.with_payload_size(TCPConfig::MAX_PAYLOAD_SIZE - TCPHeader::TIMESTAMPS_LENGTH),
+                "test 1 failed: full data segment has no room for the timestamps");
+            test_err_if(not data.header().timestamps.has_value() or data.header().timestamps->second != 1030,
+                        "test 1 failed: data segment did not echo the latest timestamp");
+        }
+
+        // test 2: active open offers timestamps with an echo of zero; a SYN/ACK without them turns them off
+        {
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Connect{});
+            TCPSegment syn = test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(false), "test 2 failed: no SYN");
+            test_err_if(not syn.header().timestamps.has_value() or syn.header().timestamps->second != 0,
+                        "test 2 failed: SYN did not offer timestamps");
+            const WrappingInt32 isn = syn.header().seqno;
+            const WrappingInt32 seq_base(rd());
+
+            test_2.send_syn(seq_base, isn + 1);
+            TCPSegment ack =
+                test_2.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(seq_base + 1), "test 2 failed: no ACK");
+            test_err_if(ack.header().timestamps.has_value(), "test 2 failed: timestamps were not turned off");
+            test_2.execute(ExpectState{State::ESTABLISHED});
+        }
+
+        // test 3: timestamps are disabled locally; the peer's timestamps are ignored
+        {
+            TCPConfig plain = cfg;
+            plain.timestamps = false;
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_3(plain);
+            test_3.execute(Listen{});
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(10000).with_timestamps(1000, 0));
+            TCPSegment syn_ack = test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                   "test 3 failed: no SYN/ACK");
+            test_err_if(syn_ack.header().timestamps.has_value(), "test 3 failed: SYN/ACK carried timestamps");
+        }
+
+        // test 4: PAWS does not apply to RSTs, so an in-window RST with an old timestamp still resets
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_4(cfg);
+            test_4.execute(Listen{});
+            test_4.execute(SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(10000).with_timestamps(1000, 0));
+            TCPSegment syn_ack = test_4.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                   "test 4 failed: no SYN/ACK");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            test_4.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(10000)
+                               .with_timestamps(2000, 0));
+            test_4.execute(ExpectState{State::ESTABLISHED});
+
+            test_4.execute(SendSegment{}.with_rst(true).with_seqno(seq_base + 1).with_timestamps(1500, 0));
+            test_4.execute(ExpectState{State::RESET});
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: RST was answered");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static constexpr size_t BIG_CAPACITY = 1 << 20;
+//1 MiB的窗口右移5位之后才能放进16位的窗口字段
+static constexpr uint8_t BIG_SHIFT = 5;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.window_scaling = true;
+        cfg.recv_capacity = BIG_CAPACITY;
+        cfg.send_capacity = BIG_CAPACITY;
+        cfg.congestion_control = CongestionControl::Algorithm::None;
+
+        // test 1: both sides scale; windows are scaled in both directions after the handshake
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Listen{});
+            test_1.execute(SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(1000).with_window_scale(3));
+
+            // the window in a SYN is never scaled
+            TCPSegment syn_ack = test_1.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(seq_base + 1).with_win(65535),
+                "test 1 failed: no SYN/ACK");
+            test_err_if(syn_ack.header().window_scale != BIG_SHIFT, "test 1 failed: wrong shift in SYN/ACK");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            test_1.send_ack(seq_base + 1, ack_base + 1, 1000);
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            // the peer's window of 1000 means 8000 bytes
+            test_1.execute(Write{string(20000, 'x')}.with_bytes_written(20000));
+            test_1.execute(Tick(1));
+            size_t bytes_sent = 0;
+            while (test_1.can_read()) {
+                bytes_sent += test_1
+                                  .expect_seg(ExpectSegment{}.with_ackno(seq_base + 1).with_win(BIG_CAPACITY >> BIG_SHIFT),
+                                              "test 1 failed: data segment has the wrong window")
+                                  .payload()
+                                  .size();
+            }
+            test_err_if(bytes_sent != 8000, "test 1 failed: sender did not use the scaled window");
+            test_1.execute(ExpectBytesInFlight{8000});
+
+            // received data shrinks the advertised window in units of 32 bytes
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(1000)
+                               .with_data(string(100, 'y')));
+            test_1.execute(ExpectOneSegment{}
+                               .with_ackno(seq_base + 101)
+                               .with_win((BIG_CAPACITY - 100) >> BIG_SHIFT)
+                               .with_payload_size(0),
+                           "test 1 failed: wrong window after receiving data");
+        }
+
+        // test 2: the peer does not offer the option; windows are capped at 65535 and not scaled
+        {
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Listen{});
+            test_2.send_syn(seq_base);
+            TCPSegment syn_ack =
+                test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true).with_win(65535),
+                                  "test 2 failed: no SYN/ACK");
+            test_err_if(syn_ack.header().window_scale.has_value(), "test 2 failed: SYN/ACK offered a shift");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            test_2.send_ack(seq_base + 1, ack_base + 1, 1000);
+            test_2.execute(Write{string(5000, 'x')});
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_payload_size(1000).with_win(65535),
+                           "test 2 failed: window was scaled without negotiation");
+            test_2.execute(ExpectBytesInFlight{1000});
+        }
+
+        // test 3: active open offers the option, but the peer's SYN/ACK does not carry it
+        {
+            TCPTestHarness test_3(cfg);
+            test_3.execute(Connect{});
+            TCPSegment syn = test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(false), "test 3 failed: no SYN");
+            test_err_if(syn.header().window_scale != BIG_SHIFT, "test 3 failed: SYN did not offer a shift");
+            const WrappingInt32 isn = syn.header().seqno;
+            const WrappingInt32 seq_base(rd());
+
+            test_3.send_syn(seq_base, isn + 1);
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(seq_base + 1).with_win(65535),
+                           "test 3 failed: ACK of SYN");
+            test_3.execute(ExpectState{State::ESTABLISHED});
+        }
+
+        // test 4: window scaling is disabled locally; the peer's shift is ignored
+        {
+            TCPConfig plain = cfg;
+            plain.window_scaling = false;
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_4(plain);
+            test_4.execute(Listen{});
+            test_4.execute(SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(1000).with_window_scale(3));
+            TCPSegment syn_ack = test_4.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true),
+                                                   "test 4 failed: no SYN/ACK");
+            test_err_if(syn_ack.header().window_scale.has_value(), "test 4 failed: SYN/ACK offered a shift");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            test_4.send_ack(seq_base + 1, ack_base + 1, 1000);
+            test_4.execute(Write{string(5000, 'x')});
+            test_4.execute(Tick(1));
+            test_4.execute(ExpectOneSegment{}.with_payload_size(1000), "test 4 failed: peer's shift was applied");
+            test_4.execute(ExpectBytesInFlight{1000});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -29,6 +29,9 @@ int main() {
         auto rd = get_random_generator();
         TCPConfig cfg{};
         cfg.send_capacity = MAX_SWIN * MAX_SWIN_MUL;
+        // the test expects the whole receiver window (up to 34 KB) to go out before any ACK, which is more
+        // than NewReno's initial window of ten segments; only the receiver's window is under test here
+        cfg.congestion_control = CongestionControl::Algorithm::None;
 
         // test 1: listen -> established -> check advertised winsize -> check sent bytes before ACK
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
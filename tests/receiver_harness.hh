@@ -13,6 +13,8 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 struct ReceiverTestStep {
     virtual std::string to_string() const { return "ReceiverTestStep"; }
@@ -84,6 +86,21 @@ struct ExpectWindow : public ReceiverExpectation {
     }
 };
 
+struct ExpectCapacity : public ReceiverExpectation {
+    size_t _capacity;
+
+    ExpectCapacity(const size_t capacity) : _capacity(capacity) {}
+    std::string description() const { return "capacity " + std::to_string(_capacity); }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.capacity() != _capacity) {
+            throw ReceiverExpectationViolation("The TCPReceiver reported capacity `" +
+                                               std::to_string(receiver.capacity()) + "`, but it was expected to be `" +
+                                               std::to_string(_capacity) + "`");
+        }
+    }
+};
+
 struct ExpectUnassembledBytes : public ReceiverExpectation {
     size_t _n_bytes;
 
@@ -143,6 +160,38 @@ struct ExpectBytes : public ReceiverExpectation {
     }
 };
 
+struct ExpectSackBlocks : public ReceiverExpectation {
+    std::vector<std::pair<uint32_t, uint32_t>> _blocks;
+    size_t _max_blocks;
+
+    ExpectSackBlocks(std::vector<std::pair<uint32_t, uint32_t>> blocks, const size_t max_blocks = 4)
+        : _blocks(std::move(blocks)), _max_blocks(max_blocks) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "SACK blocks (at most " << _max_blocks << "):";
+        for (const auto &[left, right] : _blocks) {
+            ss << " " << left << "-" << right;
+        }
+        return ss.str();
+    }
+
+    void execute(TCPReceiver &receiver) const {
+        std::vector<std::pair<uint32_t, uint32_t>> reported;
+        for (const auto &[left, right] : receiver.sack_blocks(_max_blocks)) {
+            reported.emplace_back(left.raw_value(), right.raw_value());
+        }
+        if (reported != _blocks) {
+            std::ostringstream ss;
+            ss << "The TCPReceiver reported SACK blocks";
+            for (const auto &[left, right] : reported) {
+                ss << " " << left << "-" << right;
+            }
+            ss << ", but it was expected to report" << description().substr(description().find(':') + 1);
+            throw ReceiverExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ReceiverAction : public ReceiverTestStep {
     std::string to_string() const { return "Action:      " + description(); }
     virtual std::string description() const { return "description missing"; }
@@ -273,15 +322,41 @@ struct SegmentArrives : public ReceiverAction {
     }
 };
 
+struct WindowAdvertised : public ReceiverAction {
+    std::string description() const override { return "window advertised"; }
+    void execute(TCPReceiver &receiver) const override { receiver.window_advertised(); }
+};
+
+struct Tick : public ReceiverAction {
+    size_t _ms;
+    double _rtt_ms;
+
+    Tick(const size_t ms, const double rtt_ms) : _ms(ms), _rtt_ms(rtt_ms) {}
+    std::string description() const override {
+        std::ostringstream ss;
+        ss << _ms << " ms pass (rtt " << _rtt_ms << " ms)";
+        return ss.str();
+    }
+    void execute(TCPReceiver &receiver) const override { receiver.tick(_ms, _rtt_ms); }
+};
+
 class TCPReceiverTestHarness {
     TCPReceiver receiver;
     std::vector<std::string> steps_executed;
 
   public:
-    TCPReceiverTestHarness(size_t capacity) : receiver(capacity), steps_executed() {
+    TCPReceiverTestHarness(size_t capacity,
+                           const bool windowed = false,
+                           const bool autotune = false,
+                           const size_t min_capacity = 0)
+        : receiver(capacity, false, windowed, autotune, min_capacity), steps_executed() {
         std::ostringstream ss;
         ss << "Initialized with ("
-           << "capacity=" << capacity << ")";
+           << "capacity=" << capacity << (windowed ? ", windowed" : "");
+        if (autotune) {
+            ss << ", autotune from " << min_capacity;
+        }
+        ss << ")";
         steps_executed.emplace_back(ss.str());
     }
     void execute(const ReceiverTestStep &step) {
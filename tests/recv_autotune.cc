@@ -0,0 +1,141 @@
+#include "receiver_harness.hh"
+#include "tcp_memory.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+//每个rtt在应用读走的两倍之上再留的余量
+static constexpr size_t HEADROOM = 16 * TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // both reassembler engines resize the same way
+        for (const bool windowed : {false, true}) {
+            uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test{200000, windowed, true, 20000};
+            test.execute(ExpectCapacity{20000});
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectWindow{20000});
+
+            // nothing happens before the first RTT sample
+            test.execute(SegmentArrives{}
+                             .with_seqno(isn + 1)
+                             .with_data(string(10000, 'x'))
+                             .with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectBytes{string(10000, 'x')});
+            test.execute(Tick{100, 0});
+            test.execute(ExpectCapacity{20000});
+
+            // 10000 bytes read in one RTT: twice that plus 16 segments of headroom
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 10001).with_data("abc").with_result(SegmentArrives::Result::OK));
+            test.execute(Tick{5, 10});
+            test.execute(ExpectCapacity{20000});
+            test.execute(Tick{5, 10});
+            test.execute(ExpectCapacity{20000 + HEADROOM});
+            test.execute(ExpectWindow{20000 + HEADROOM - 3});
+            // unread data survives the resize
+            test.execute(ExpectBytes{"abc"});
+
+            // an idle application: the capacity may not pull back the advertised right edge
+            test.execute(WindowAdvertised{});
+            test.execute(Tick{10, 10});
+            test.execute(ExpectCapacity{20000 + HEADROOM});
+            test.execute(SegmentArrives{}
+                             .with_seqno(isn + 10004)
+                             .with_data(string(6000, 'y'))
+                             .with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectBytes{string(6000, 'y')});
+            test.execute(Tick{10, 10});
+            test.execute(ExpectCapacity{20000 + HEADROOM - 6000});
+            test.execute(ExpectWindow{20000 + HEADROOM - 6000});
+
+            // no shrinking while data is missing
+            test.execute(WindowAdvertised{});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 16014).with_data("z").with_result(SegmentArrives::Result::OK));
+            test.execute(Tick{10, 10});
+            test.execute(ExpectCapacity{20000 + HEADROOM - 6000});
+            test.execute(ExpectUnassembledBytes{1});
+
+            // the gap fills and the application reads on: the advertised edge still holds the capacity up
+            test.execute(SegmentArrives{}
+                             .with_seqno(isn + 16004)
+                             .with_data("0123456789")
+                             .with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectBytes{"0123456789z"});
+            test.execute(Tick{10, 10});
+            test.execute(ExpectCapacity{20000 + HEADROOM - 6011});
+            test.execute(Tick{10, 10});
+            test.execute(ExpectCapacity{20000 + HEADROOM - 6011});
+        }
+
+        // the configured capacity is the upper bound
+        {
+            uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test{30000, false, true, 20000};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(SegmentArrives{}
+                             .with_seqno(isn + 1)
+                             .with_data(string(15000, 'x'))
+                             .with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectBytes{string(15000, 'x')});
+            test.execute(Tick{10, 10});
+            test.execute(ExpectCapacity{30000});
+            test.execute(ExpectWindow{30000});
+        }
+
+        // the process's memory budget: growth stops at it, and past it the capacity heads back to the lower bound
+        {
+            uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test{200000, false, true, 20000};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(SegmentArrives{}
+                             .with_seqno(isn + 1)
+                             .with_data(string(10000, 'x'))
+                             .with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectBytes{string(10000, 'x')});
+            TCPMemory::set_limit(TCPMemory::allocated() + 1000);
+            test.execute(Tick{10, 10});
+            test.execute(ExpectCapacity{21000});
+            TCPMemory::set_limit(TCPMemory::allocated() - 1);
+            test.execute(SegmentArrives{}
+                             .with_seqno(isn + 10001)
+                             .with_data(string(10000, 'x'))
+                             .with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectBytes{string(10000, 'x')});
+            test.execute(Tick{10, 10});
+            test.execute(ExpectCapacity{20000});
+            TCPMemory::set_limit(0);
+        }
+
+        // without auto-tuning the capacity is fixed
+        {
+            uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test{20000};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(SegmentArrives{}
+                             .with_seqno(isn + 1)
+                             .with_data(string(15000, 'x'))
+                             .with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectBytes{string(15000, 'x')});
+            test.execute(Tick{10, 10});
+            test.execute(ExpectCapacity{20000});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#include "receiver_harness.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // both reassembler engines report the same blocks
+        for (const bool windowed : {false, true}) {
+            uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test{4000, windowed};
+            test.execute(ExpectSackBlocks{{}});
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{}});
+
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 5).with_data("efgh").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{isn + 5, isn + 9}}});
+            // the block holding the latest segment comes first
+            test.execute(SegmentArrives{}.with_seqno(isn + 13).with_data("mn").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{isn + 13, isn + 15}, {isn + 5, isn + 9}}});
+            // adjacent data merges into one block
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 9).with_data("ijkl").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{isn + 5, isn + 15}}});
+
+            for (uint32_t i = 0; i < 4; ++i) {
+                test.execute(SegmentArrives{}
+                                 .with_seqno(isn + 20 + 5 * i)
+                                 .with_data("x")
+                                 .with_result(SegmentArrives::Result::OK));
+            }
+            // the latest block, then the lowest ones
+            test.execute(ExpectSackBlocks{{{isn + 35, isn + 36},
+                                           {isn + 5, isn + 15},
+                                           {isn + 20, isn + 21},
+                                           {isn + 25, isn + 26}}});
+            test.execute(ExpectSackBlocks{{{isn + 35, isn + 36}, {isn + 5, isn + 15}}, 2});
+            test.execute(ExpectSackBlocks{{}, 0});
+
+            // a duplicate of old data moves its block to the front
+            test.execute(SegmentArrives{}.with_seqno(isn + 25).with_data("x").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{isn + 25, isn + 26},
+                                           {isn + 5, isn + 15},
+                                           {isn + 20, isn + 21},
+                                           {isn + 30, isn + 31}}});
+
+            // filling the first hole: the block below the ackno is gone
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 1).with_data("abcd").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectAckno{WrappingInt32{isn + 15}});
+            test.execute(ExpectUnassembledBytes{4});
+            test.execute(ExpectSackBlocks{{{isn + 20, isn + 21},
+                                           {isn + 25, isn + 26},
+                                           {isn + 30, isn + 31},
+                                           {isn + 35, isn + 36}}});
+        }
+
+        // blocks wrap around the sequence space like everything else
+        for (const bool windowed : {false, true}) {
+            const uint32_t isn = UINT32_MAX - 2;
+            TCPReceiverTestHarness test{4000, windowed};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 2).with_data("cdef").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{isn + 2, isn + 6}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("a").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{}});
+            test.execute(ExpectBytes{"acdef"});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#include "sender_harness.hh"
+#include "tcp_memory.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t allocated_before = TCPMemory::allocated();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.send_capacity = 100 * MSS;
+            cfg.send_autotune = true;
+
+            TCPSenderTestHarness test{"The send buffer grows with the congestion window", cfg};
+            test.execute(ExpectCapacity{TCPConfig::SEND_CAPACITY_MIN_DFLT});
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            // two initial windows of 10 segments
+            test.execute(ExpectCapacity{20 * MSS});
+            test.execute(WriteBytes{string(10 * MSS, 'x')});
+            for (unsigned i = 1; i <= 10; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + i * MSS}}.with_win(60000));
+            }
+            test.execute(ExpectCongestionWindow{20 * MSS});
+            test.execute(ExpectCapacity{40 * MSS});
+            // the peer's window (50000 bytes) is now smaller than the congestion window of 40 segments
+            test.execute(WriteBytes{string(20 * MSS, 'y')});
+            for (unsigned i = 11; i <= 30; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + i * MSS}}.with_win(50000));
+            }
+            test.execute(ExpectCongestionWindow{40 * MSS});
+            test.execute(ExpectCapacity{100000});
+            // a smaller window later does not shrink it
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 30 * MSS}}.with_win(1000));
+            test.execute(ExpectCapacity{100000});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.send_capacity = 100 * MSS;
+            cfg.send_autotune = true;
+
+            TCPSenderTestHarness test{"The send buffer stays within the memory budget", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            TCPMemory::set_limit(TCPMemory::allocated() + 5000);
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(10 * MSS, 'x')});
+            for (unsigned i = 1; i <= 10; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + i * MSS}}.with_win(60000));
+            }
+            test.execute(ExpectCapacity{20 * MSS + 5000});
+            test.execute(WriteBytes{string(40 * MSS, 'y')});
+
+            // under pressure the next tick shrinks it back to the minimum
+            TCPMemory::set_limit(TCPMemory::allocated() - 1);
+            test.execute(Tick{1});
+            test.execute(ExpectCapacity{20 * MSS});
+            TCPMemory::set_limit(0);
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without auto-sizing the capacity is fixed", cfg};
+            test.execute(ExpectCapacity{TCPConfig::DEFAULT_CAPACITY});
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            TCPMemory::set_limit(1);
+            test.execute(Tick{1});
+            test.execute(ExpectCapacity{TCPConfig::DEFAULT_CAPACITY});
+            TCPMemory::set_limit(0);
+        }
+
+        if (TCPMemory::allocated() != allocated_before) {
+            cerr << "The senders did not give their memory back: " << TCPMemory::allocated() << " bytes charged, "
+                 << allocated_before << " before" << endl;
+            return 1;
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
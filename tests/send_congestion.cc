@@ -0,0 +1,335 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+static constexpr size_t IW = 10 * MSS;
+static constexpr uint16_t BIG_WINDOW = 65000;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Initial window is ten segments", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{IW}.with_ssthresh(numeric_limits<size_t>::max()));
+            test.execute(WriteBytes{string(20 * MSS, 'x')});
+            // the harness hands back the most recently sent segment first
+            for (unsigned i = 10; i-- > 0;) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{IW});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Slow start grows the window by one MSS per ACK", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(30 * MSS, 'x')});
+            for (unsigned i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // one segment acknowledged: one segment's worth of room plus one MSS of growth
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{IW + MSS});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 11 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 10 * MSS));
+            test.execute(ExpectNoSegment{});
+
+            // a cumulative ACK of several segments still grows the window by only one MSS
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{IW + 2 * MSS});
+            test.execute(ExpectBytesInFlight{IW + 2 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"The receiver's window still applies", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3000));
+            test.execute(WriteBytes{string(20 * MSS, 'x')});
+            test.execute(ExpectSegment{}.with_payload_size(3000 - 2 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{3000});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"A timeout shrinks the window to one MSS", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(30 * MSS, 'x')});
+            for (unsigned i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{MSS}.with_ssthresh(IW / 2));
+
+            // everything is acknowledged, but only slow start's one MSS of growth is allowed
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{2 * MSS});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 11 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 10 * MSS));
+            test.execute(ExpectNoSegment{});
+
+            // slow start up to ssthresh, then one MSS per window of acknowledged data
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 12 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{3 * MSS});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 15 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{4 * MSS});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 19 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{5 * MSS});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 24 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{6 * MSS});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 27 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{6 * MSS});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 30 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{7 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::None;
+            cfg.send_capacity = 2 * BIG_WINDOW;
+
+            TCPSenderTestHarness test{"Without congestion control, the whole receiver window is used", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(BIG_WINDOW, 'x')});
+            test.execute(ExpectBytesInFlight{BIG_WINDOW});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::Cubic;
+
+            TCPSenderTestHarness test{"CUBIC: a timeout shrinks the window to one MSS, ssthresh to 0.7 cwnd", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(ExpectCongestionWindow{IW});
+            test.execute(WriteBytes{string(30 * MSS, 'x')});
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectCongestionWindow{MSS}.with_ssthresh(IW * 7 / 10));
+
+            // the backed-off retransmission of the same segment does not shrink it again
+            test.execute(Tick{2 * size_t{cfg.rt_timeout}});
+            test.execute(ExpectCongestionWindow{MSS}.with_ssthresh(IW * 7 / 10));
+        }
+
+        for (const bool rtt_rises : {true, false}) {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::Cubic;
+
+            TCPSenderTestHarness test{rtt_rises ? "CUBIC: HyStart leaves slow start when the RTT rises"
+                                                : "CUBIC: HyStart stays in slow start while the RTT is steady",
+                                      cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(40 * MSS, 'x')});
+
+            // first round: ten segments, each acknowledged after 100 ms
+            test.execute(Tick{100});
+            for (unsigned i = 1; i <= 10; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + i * MSS}}.with_win(BIG_WINDOW));
+            }
+            test.execute(ExpectCongestionWindow{20 * MSS}.with_ssthresh(numeric_limits<size_t>::max()));
+
+            // second round: the segments sent during the first round come back later (or just as fast)
+            test.execute(Tick{rtt_rises ? 150U : 100U});
+            for (unsigned i = 11; i <= 18; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + i * MSS}}.with_win(BIG_WINDOW));
+            }
+            if (rtt_rises) {
+                test.execute(ExpectCongestionWindow{28 * MSS}.with_ssthresh(28 * MSS));
+            } else {
+                test.execute(ExpectCongestionWindow{28 * MSS}.with_ssthresh(numeric_limits<size_t>::max()));
+            }
+        }
+
+        {
+            // the window after a loss, driven directly, one window of ACKs per 100 ms round trip
+            constexpr uint64_t RTT = 100;
+            constexpr size_t W_MAX = 100 * MSS;
+            Cubic cubic{MSS};
+            uint64_t now = 0;
+            const auto round_trip = [&] {
+                now += RTT;
+                for (size_t acked = 0, cwnd = cubic.cwnd(); acked < cwnd; acked += MSS) {
+                    cubic.on_ack({now, MSS, cwnd, RTT, 0, 0});
+                }
+            };
+
+            while (cubic.cwnd() < W_MAX) {
+                cubic.on_ack({now, MSS, W_MAX, RTT, 0, 0});
+            }
+            cubic.on_loss(W_MAX);
+            if (cubic.w_max() != W_MAX or cubic.cwnd() != W_MAX * 7 / 10 or cubic.ssthresh() != W_MAX * 7 / 10) {
+                throw runtime_error("CUBIC: a loss should remember W_max and cut the window to 0.7 W_max");
+            }
+
+            // concave: fast growth right after the loss, slowing down on the approach to W_max
+            const double k = cbrt(W_MAX / MSS * (1 - Cubic::BETA) / Cubic::C);
+            const unsigned rounds_to_k = static_cast<unsigned>(k * 1000 / RTT);
+            size_t previous = cubic.cwnd();
+            size_t first_growth = 0, last_growth = 0;
+            for (unsigned i = 0; i + 2 < rounds_to_k; ++i) {
+                round_trip();
+                last_growth = cubic.cwnd() - previous;
+                first_growth = first_growth ? first_growth : last_growth;
+                previous = cubic.cwnd();
+                if (cubic.cwnd() >= W_MAX) {
+                    throw runtime_error("CUBIC: the window reached W_max before K seconds had passed");
+                }
+            }
+            if (last_growth * 4 > first_growth) {
+                throw runtime_error("CUBIC: the window did not flatten out near W_max");
+            }
+
+            // plateau around W_max at time K, then convex probing beyond it
+            for (unsigned i = 0; i < 4; ++i) {
+                round_trip();
+            }
+            if (cubic.cwnd() < W_MAX * 97 / 100 or cubic.cwnd() > W_MAX * 103 / 100) {
+                throw runtime_error("CUBIC: the window should be close to W_max after K seconds, not " +
+                                    to_string(cubic.cwnd()));
+            }
+            for (unsigned i = 0; i < rounds_to_k; ++i) {
+                round_trip();
+            }
+            if (cubic.cwnd() < W_MAX * 5 / 4) {
+                throw runtime_error("CUBIC: the window should grow past W_max after 2K seconds");
+            }
+
+            // a loss below the previous W_max releases bandwidth faster (fast convergence)
+            Cubic second{MSS};
+            while (second.cwnd() < W_MAX) {
+                second.on_ack({now, MSS, W_MAX, RTT, 0, 0});
+            }
+            second.on_loss(W_MAX);
+            second.on_loss(second.cwnd());
+            if (second.w_max() != static_cast<size_t>(W_MAX * 0.7 * (1 + Cubic::BETA) / 2)) {
+                throw runtime_error("CUBIC: fast convergence should lower W_max");
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::Bbr;
+
+            TCPSenderTestHarness test{"BBR: new data is paced once there is a bandwidth estimate", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(30 * MSS, 'x')});
+            for (unsigned i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+
+            // the first delivery-rate sample starts the pacing: the window has room, but no budget yet
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectNoSegment{});
+
+            // one millisecond of budget at 2.885 * (1452 bytes / 100 ms) lets one segment go
+            test.execute(Tick{1});
+            test.execute(WriteBytes{""});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 10 * MSS));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            // BBR driven directly over a path with a 100 ms RTT and a bottleneck of one MSS per millisecond
+            constexpr uint64_t RTT = 100;
+            constexpr double BW = MSS;
+            constexpr size_t BDP = RTT * MSS;
+            Bbr bbr{MSS};
+            uint64_t now = 0, acked = 0;
+            // one round trip: everything the window allows (up to what the bottleneck delivers) is acknowledged
+            const auto round_trip = [&](const uint64_t rtt) {
+                now += rtt;
+                const size_t flight = min(bbr.cwnd(), static_cast<size_t>(BW * rtt));
+                const double rate = min(static_cast<double>(bbr.cwnd()) / rtt, BW);
+                const uint64_t round_end = acked + flight;
+                for (size_t n = 0; n < flight; n += MSS) {
+                    acked += MSS;
+                    bbr.on_ack({now, MSS, round_end - acked, rtt, acked, round_end, rate, false});
+                }
+            };
+
+            for (unsigned i = 0; i < 20 and bbr.mode() != Bbr::Mode::ProbeBW; ++i) {
+                round_trip(RTT);
+            }
+            if (bbr.mode() != Bbr::Mode::ProbeBW) {
+                throw runtime_error("BBR: should have gone through Startup and Drain to ProbeBW");
+            }
+            if (bbr.bottleneck_bandwidth() != BW or bbr.min_rtt() != RTT) {
+                throw runtime_error("BBR: wrong model of the path");
+            }
+            if (bbr.cwnd() != static_cast<size_t>(Bbr::CWND_GAIN * BDP)) {
+                throw runtime_error("BBR: the window should be two bandwidth-delay products, not " +
+                                    to_string(bbr.cwnd()));
+            }
+            const double pacing = bbr.pacing_rate().value();
+            if (pacing < 0.75 * BW or pacing > 1.25 * BW) {
+                throw runtime_error("BBR: should pace at about the bottleneck bandwidth");
+            }
+
+            // ten seconds without a lower RTT (a standing queue): drain the flight to measure it again
+            while (bbr.mode() != Bbr::Mode::ProbeRTT) {
+                round_trip(RTT + 20);
+            }
+            if (bbr.cwnd() != Bbr::MIN_CWND_SEGMENTS * MSS) {
+                throw runtime_error("BBR: ProbeRTT should shrink the window to four segments");
+            }
+            for (unsigned i = 0; i < 10 and bbr.mode() == Bbr::Mode::ProbeRTT; ++i) {
+                round_trip(RTT);
+            }
+            if (bbr.mode() != Bbr::Mode::ProbeBW or bbr.cwnd() < static_cast<size_t>(Bbr::CWND_GAIN * BDP)) {
+                throw runtime_error("BBR: should return to ProbeBW with the window it had before ProbeRTT");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
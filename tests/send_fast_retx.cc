@@ -0,0 +1,155 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+static constexpr uint16_t BIG_WINDOW = 65000;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Third duplicate ACK retransmits without waiting for the timer", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(6 * MSS, 'x')});
+            for (unsigned i = 6; i-- > 0;) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            // the second segment was lost: the receiver keeps ACKing the end of the first
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            for (unsigned dup = 1; dup < 3; ++dup) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+                test.execute(ExpectNoSegment{});
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+            test.execute(ExpectNoSegment{});
+            // the window is halved once, to half of the data in flight
+            test.execute(ExpectCongestionWindow{5 * MSS / 2}.with_ssthresh(5 * MSS / 2));
+            test.execute(ExpectBytesInFlight{5 * MSS});
+            // a fast retransmission is not a timeout
+            test.execute(Tick{1}.with_max_retx_exceeded(false));
+            test.execute(ExpectState{TCPSenderStateSummary::SYN_ACKED});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Window updates and data segments are not duplicate ACKs", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(6 * MSS, 'x')});
+            for (unsigned i = 0; i < 6; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            for (unsigned i = 1; i <= 3; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW - i));
+            }
+            test.execute(ExpectNoSegment{});
+            for (unsigned i = 0; i < 3; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW - 3).with_data());
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{11 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Fast recovery: window inflation, partial and full ACKs", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(9 * MSS, 'x')});
+            for (unsigned i = 0; i < 9; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            // the second and fourth segments are lost
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            for (unsigned dup = 0; dup < 3; ++dup) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+            test.execute(ExpectCongestionWindow{4 * MSS}.with_ssthresh(4 * MSS));
+
+            // ssthresh plus three segments that have left the network is still less than what is in flight
+            test.execute(WriteBytes{string(2 * MSS, 'y')});
+            test.execute(ExpectNoSegment{});
+            // each further duplicate ACK inflates the window by one segment
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 9 * MSS));
+            test.execute(ExpectNoSegment{});
+
+            // partial ACK: the retransmission arrived, and the next hole is retransmitted right away
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 10 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 3 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{4 * MSS});
+
+            // full ACK of everything sent before the fast retransmit ends recovery
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 9 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{4 * MSS});
+            test.execute(ExpectBytesInFlight{2 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"No second fast retransmit for the same window after a timeout", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(9 * MSS, 'x')});
+            for (unsigned i = 0; i < 9; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            for (unsigned dup = 0; dup < 3; ++dup) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+
+            // the retransmission was lost too: the timer still repairs it
+            test.execute(Tick{cfg.rt_timeout - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+            test.execute(ExpectCongestionWindow{MSS});
+
+            // duplicate ACKs for data sent before the timeout do not shrink the window again
+            for (unsigned dup = 0; dup < 3; ++dup) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(BIG_WINDOW));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{MSS}.with_ssthresh(4 * MSS));
+        }
+
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::None;
+            cfg.pacing = true;
+            cfg.pacing_rate = 1000 * 1000;
+
+            TCPSenderTestHarness test{"A fixed rate releases segments as the budget allows", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(ExpectNextSend{nullopt});
+            test.execute(WriteBytes{string(5000, 'x')});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectNextSend{1});
+            // 1000 bytes per ms: each segment overdraws the budget, which later ticks pay back
+            test.execute(Tick{1});
+            test.execute(WriteBytes{""});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectNextSend{1});
+            test.execute(Tick{1});
+            test.execute(WriteBytes{""});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+            test.execute(Tick{1});
+            test.execute(WriteBytes{""});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 2 * MSS));
+            test.execute(ExpectNextSend{2});
+            test.execute(Tick{1});
+            test.execute(WriteBytes{""});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectNextSend{1});
+            test.execute(Tick{1});
+            test.execute(WriteBytes{""});
+            test.execute(ExpectSegment{}.with_payload_size(5000 - 3 * MSS).with_seqno(isn + 1 + 3 * MSS));
+            test.execute(ExpectNextSend{nullopt});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+
+            TCPSenderTestHarness test{"Without a fixed rate, slow start paces at twice cwnd / SRTT", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(65000));
+            // 10 segments every 10 ms, twice that in slow start: two segments per ms
+            test.execute(WriteBytes{string(6 * MSS, 'x')});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectNextSend{1});
+            for (unsigned i = 0; i < 3; i++) {
+                test.execute(Tick{1});
+                test.execute(WriteBytes{""});
+                test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + (2 * i + 1) * MSS));
+                test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 2 * i * MSS));
+                test.execute(ExpectNoSegment{});
+            }
+            test.execute(ExpectNextSend{nullopt});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without pacing the window leaves at once", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(65000));
+            test.execute(WriteBytes{string(6 * MSS, 'x')});
+            for (unsigned i = 6; i-- > 0;) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + i * MSS));
+            }
+            test.execute(ExpectNextSend{nullopt});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
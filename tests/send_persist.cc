@@ -0,0 +1,112 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uint16_t(rd() % 1000) + 100;
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"A zero window is probed with exponential backoff, never giving up", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(0));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+            // the first probe goes out after one retransmission timeout
+            test.execute(Tick(rto - 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick(1));
+            test.execute(ExpectSegment{}.with_no_flags().with_data("a").with_seqno(isn + 1));
+            test.execute(ExpectBytesInFlight{1});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(0));
+            test.execute(ExpectNoSegment{});
+            // many more probes than MAX_RETX_ATTEMPTS, each interval twice the last one up to the maximum
+            size_t interval = rto;
+            for (unsigned i = 0; i < 2 * TCPConfig::MAX_RETX_ATTEMPTS; i++) {
+                interval = min<size_t>(2 * interval, TCPConfig::PERSIST_TIMEOUT_MAX_MS);
+                test.execute(Tick(interval - 1));
+                test.execute(ExpectNoSegment{});
+                test.execute(Tick(1).with_max_retx_exceeded(false));
+                test.execute(ExpectSegment{}.with_no_flags().with_data("a").with_seqno(isn + 1));
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(0));
+                test.execute(ExpectNoSegment{});
+            }
+            test.execute(ExpectRTO{rto});
+            // the window opens: the probe and the rest go out at once
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectSegment{}.with_no_flags().with_data("bc").with_seqno(isn + 2));
+            test.execute(ExpectSegment{}.with_no_flags().with_data("a").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("def").with_seqno(isn + 4));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uint16_t(rd() % 1000) + 100;
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"Data in flight when the window closes is probed, not retransmitted", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(6));
+            test.execute(WriteBytes{"abcdefgh"});
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abcdef").with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(0));
+            test.execute(Tick(rto).with_max_retx_exceeded(false));
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abcdef").with_seqno(isn + 1));
+            test.execute(ExpectRTO{rto});
+            test.execute(Tick(2 * rto - 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick(1));
+            test.execute(ExpectSegment{}.with_no_flags().with_data("abcdef").with_seqno(isn + 1));
+            // the peer takes the data but its window is still closed: the next byte becomes the probe
+            test.execute(AckReceived{WrappingInt32{isn + 7}}.with_win(0));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick(4 * rto));
+            test.execute(ExpectSegment{}.with_no_flags().with_data("g").with_seqno(isn + 7));
+            test.execute(AckReceived{WrappingInt32{isn + 8}}.with_win(10));
+            test.execute(ExpectSegment{}.with_no_flags().with_data("h").with_seqno(isn + 8));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"A FIN alone probes a zero window", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(0));
+            test.execute(Close{});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick(cfg.rt_timeout));
+            test.execute(ExpectSegment{}.with_fin(true).with_payload_size(0).with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_win(0));
+            test.execute(ExpectState{TCPSenderStateSummary::FIN_ACKED});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without adaptive RTO, measurements leave the timeout alone", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTO{TCPConfig::TIMEOUT_DFLT});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"SRTT and RTTVAR follow RFC 6298", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRTO{TCPConfig::TIMEOUT_DFLT});
+            // first measurement: SRTT = R, RTTVAR = R/2, RTO = SRTT + 4 * RTTVAR
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTO{120});
+            // RTTVAR = 3/4 * 20 + 1/4 * |40 - 40|, SRTT = 7/8 * 40 + 1/8 * 40
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectRTO{100});
+            // RTTVAR = 3/4 * 15 + 1/4 * |40 - 80|, SRTT = 7/8 * 40 + 1/8 * 80
+            test.execute(WriteBytes{"de"});
+            test.execute(ExpectSegment{}.with_data("de"));
+            test.execute(Tick{80});
+            test.execute(AckReceived{WrappingInt32{isn + 6}}.with_win(1000));
+            test.execute(ExpectRTO{130});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"A short path retransmits after rto_min", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{1});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTO{TCPConfig::RTO_MIN_DFLT});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{TCPConfig::RTO_MIN_DFLT - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(ExpectRTO{2 * TCPConfig::RTO_MIN_DFLT});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 200;
+
+            TCPSenderTestHarness test{"The timeout is at least rto_min", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRTO{200});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_max = 300;
+
+            TCPSenderTestHarness test{"Exponential backoff stops at rto_max", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            for (const size_t rto : {120, 240, 300, 300}) {
+                test.execute(ExpectRTO{rto});
+                test.execute(Tick{rto - 1});
+                test.execute(ExpectNoSegment{});
+                test.execute(Tick{1});
+                test.execute(ExpectSegment{}.with_data("abc"));
+            }
+            test.execute(ExpectRTO{300});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"Karn's algorithm: no measurement from a retransmitted segment", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{120});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(ExpectRTO{240});
+            // ambiguous: the ACK may be for either transmission, so the backed-off timeout stays
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectRTO{240});
+            // the next new segment gives a measurement again
+            test.execute(WriteBytes{"de"});
+            test.execute(ExpectSegment{}.with_data("de"));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 6}}.with_win(1000));
+            test.execute(ExpectRTO{100});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"Timestamps measure the RTT of a retransmitted segment", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_ts_echo(0));
+            test.execute(ExpectRTO{120});
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{120});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(ExpectRTO{240});
+            // the echo tells which transmission was acknowledged: R = 10,
+            // RTTVAR = 3/4 * 20 + 1/4 * |40 - 10|, SRTT = 7/8 * 40 + 1/8 * 10
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000).with_ts_echo(160));
+            test.execute(ExpectRTO{127});
+            // an echo of a time that has not come yet is not a measurement either
+            test.execute(WriteBytes{"de"});
+            test.execute(ExpectSegment{}.with_data("de"));
+            test.execute(Tick{127});
+            test.execute(ExpectSegment{}.with_data("de"));
+            test.execute(ExpectRTO{254});
+            test.execute(Tick{5});
+            test.execute(AckReceived{WrappingInt32{isn + 6}}.with_win(1000).with_ts_echo(1000));
+            test.execute(ExpectRTO{254});
+        }
+
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
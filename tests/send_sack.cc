@@ -0,0 +1,168 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+static constexpr uint16_t BIG_WINDOW = 65000;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"SACK blocks mark whole segments and ignore bogus ranges", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(6 * MSS, 'x')});
+            for (unsigned i = 0; i < 6; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            // beyond what was sent, and empty
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(BIG_WINDOW)
+                             .with_sack(isn + 1 + 5 * MSS, isn + 1 + 7 * MSS)
+                             .with_sack(isn + 1 + 2 * MSS, isn + 1 + 2 * MSS));
+            test.execute(ExpectSackedBytes{0});
+            // only part of the third segment: nothing is marked
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(BIG_WINDOW)
+                             .with_sack(isn + 1 + 2 * MSS, isn + 1 + 3 * MSS - 1));
+            test.execute(ExpectSackedBytes{0});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(BIG_WINDOW)
+                             .with_sack(isn + 1 + 2 * MSS, isn + 1 + 3 * MSS)
+                             .with_sack(isn + 1 + 4 * MSS, isn + 1 + 5 * MSS));
+            test.execute(ExpectSackedBytes{2 * MSS});
+            // reporting the same range again counts it once
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(BIG_WINDOW)
+                             .with_sack(isn + 1 + 2 * MSS, isn + 1 + 5 * MSS));
+            test.execute(ExpectSackedBytes{3 * MSS});
+            test.execute(ExpectBytesInFlight{6 * MSS});
+            // a cumulative ACK past SACKed segments releases them
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectSackedBytes{MSS});
+            test.execute(ExpectBytesInFlight{2 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Three SACKed segments start recovery on the first ACK", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(9 * MSS, 'x')});
+            for (unsigned i = 0; i < 9; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            // the second segment is lost, the next three arrived
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}
+                             .with_win(BIG_WINDOW)
+                             .with_sack(isn + 1 + 2 * MSS, isn + 1 + 5 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{4 * MSS}.with_ssthresh(4 * MSS));
+
+            // the network holds the retransmission and the last four segments: no room for new data
+            test.execute(WriteBytes{string(2 * MSS, 'y')});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}
+                             .with_win(BIG_WINDOW)
+                             .with_sack(isn + 1 + 2 * MSS, isn + 1 + 6 * MSS));
+            test.execute(ExpectNoSegment{});
+            // every segment that leaves the network lets one new segment in
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}
+                             .with_win(BIG_WINDOW)
+                             .with_sack(isn + 1 + 2 * MSS, isn + 1 + 7 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 9 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectSackedBytes{5 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Several holes are repaired in one recovery, without a timeout", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(10 * MSS, 'x')});
+            for (unsigned i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            // the second and fourth segments are lost
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}
+                             .with_win(BIG_WINDOW)
+                             .with_sack(isn + 1 + 4 * MSS, isn + 1 + 7 * MSS)
+                             .with_sack(isn + 1 + 2 * MSS, isn + 1 + 3 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 3 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{9 * MSS / 2}.with_ssthresh(9 * MSS / 2));
+
+            // partial ACK: the hole above was already retransmitted, so nothing is sent again
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectSackedBytes{3 * MSS});
+
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectSackedBytes{0});
+            test.execute(ExpectCongestionWindow{9 * MSS / 2});
+            test.execute(Tick{4u * cfg.rt_timeout}.with_max_retx_exceeded(false));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"After a timeout the scoreboard repairs the other holes too", cfg};
+            test.execute(ExpectSegment{}.with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(BIG_WINDOW));
+            test.execute(WriteBytes{string(8 * MSS, 'x')});
+            for (unsigned i = 0; i < 8; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            // the first, fourth and fifth segments are lost; two SACKed segments are not enough to start recovery
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(BIG_WINDOW)
+                             .with_sack(isn + 1 + MSS, isn + 1 + 3 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+
+            // the retransmission fills the first hole, and the last three segments arrived too
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 3 * MSS}}
+                             .with_win(BIG_WINDOW)
+                             .with_sack(isn + 1 + 5 * MSS, isn + 1 + 8 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 4 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 3 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 8 * MSS}}.with_win(BIG_WINDOW));
+            test.execute(ExpectBytesInFlight{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
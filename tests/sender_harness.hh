@@ -15,6 +15,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -99,6 +100,105 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectSackedBytes : public SenderExpectation {
+    size_t _n_bytes;
+
+    ExpectSackedBytes(size_t n_bytes) : _n_bytes(n_bytes) {}
+    std::string description() const { return std::to_string(_n_bytes) + " bytes selectively acknowledged"; }
+
+    void execute(TCPSender &sender, std::deque<TCPSegment> &) const {
+        if (sender.sacked_bytes() != _n_bytes) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported " << sender.sacked_bytes()
+               << " bytes selectively acknowledged, but there was expected to be " << _n_bytes;
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectCongestionWindow : public SenderExpectation {
+    size_t _cwnd;
+    std::optional<size_t> _ssthresh{};
+
+    ExpectCongestionWindow(size_t cwnd) : _cwnd(cwnd) {}
+    std::string description() const {
+        return "congestion window of " + std::to_string(_cwnd) +
+               (_ssthresh.has_value() ? " (ssthresh " + std::to_string(_ssthresh.value()) + ")" : "");
+    }
+
+    ExpectCongestionWindow &with_ssthresh(size_t ssthresh) {
+        _ssthresh = ssthresh;
+        return *this;
+    }
+
+    void execute(TCPSender &sender, std::deque<TCPSegment> &) const {
+        const auto &cc = sender.congestion_control();
+        if (cc.cwnd() != _cwnd or (_ssthresh.has_value() and cc.ssthresh() != _ssthresh.value())) {
+            std::ostringstream ss;
+            ss << "The TCPSender had a congestion window of " << cc.cwnd() << " (ssthresh " << cc.ssthresh()
+               << "), but it was expected to be " << description();
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectCapacity : public SenderExpectation {
+    size_t _capacity;
+
+    ExpectCapacity(const size_t capacity) : _capacity(capacity) {}
+    std::string description() const { return "stream capacity of " + std::to_string(_capacity); }
+
+    void execute(TCPSender &sender, std::deque<TCPSegment> &) const {
+        if (sender.stream_in().capacity() != _capacity) {
+            std::ostringstream ss;
+            ss << "The TCPSender's stream had a capacity of " << sender.stream_in().capacity()
+               << ", but it was expected to be " << _capacity;
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectRTO : public SenderExpectation {
+    size_t _rto;
+
+    ExpectRTO(size_t rto) : _rto(rto) {}
+    std::string description() const { return "retransmission timeout of " + std::to_string(_rto) + " ms"; }
+
+    void execute(TCPSender &sender, std::deque<TCPSegment> &) const {
+        if (sender.rto() != _rto) {
+            std::ostringstream ss;
+            ss << "The TCPSender had a retransmission timeout of " << sender.rto() << " ms (srtt "
+               << sender.rtt().srtt() << ", rttvar " << sender.rtt().rttvar() << "), but it was expected to be "
+               << _rto << " ms";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectNextSend : public SenderExpectation {
+    std::optional<uint64_t> _delay;
+
+    ExpectNextSend(std::optional<uint64_t> delay) : _delay(delay) {}
+    std::string description() const {
+        return _delay.has_value() ? "pacer releases the next segment in " + std::to_string(_delay.value()) + " ms"
+                                  : "pacer holds nothing back";
+    }
+
+    void execute(TCPSender &sender, std::deque<TCPSegment> &) const {
+        if (sender.time_until_next_send() != _delay) {
+            std::ostringstream ss;
+            ss << "The TCPSender's pacer would release the next segment in ";
+            if (const auto delay = sender.time_until_next_send(); delay.has_value()) {
+                ss << delay.value() << " ms";
+            } else {
+                ss << "(nothing held back)";
+            }
+            ss << ", but it was expected to be " << description();
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -179,11 +279,23 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    bool _pure_ack{true};
+    std::vector<TCPHeader::SackBlock> _sack{};
+    std::optional<uint32_t> _ts_echo{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value();
+        for (const auto &[left, right] : _sack) {
+            ss << " sack " << left.raw_value() << "-" << right.raw_value();
+        }
+        if (_ts_echo.has_value()) {
+            ss << " echoing timestamp " << _ts_echo.value();
+        }
+        if (not _pure_ack) {
+            ss << " on a segment carrying data";
+        }
         return ss.str();
     }
 
@@ -192,8 +304,24 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    AckReceived &with_data() {
+        _pure_ack = false;
+        return *this;
+    }
+
+    AckReceived &with_sack(WrappingInt32 left, WrappingInt32 right) {
+        _sack.emplace_back(left, right);
+        return *this;
+    }
+
+    AckReceived &with_ts_echo(uint32_t ts_echo) {
+        _ts_echo = ts_echo;
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::deque<TCPSegment> &) const {
-        if (not sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW))) {
+        if (not sender.ack_received(
+                _ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW), _pure_ack, _sack, _ts_echo)) {
             sender.send_empty_segment();
         }
         sender.fill_window();
@@ -385,7 +513,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
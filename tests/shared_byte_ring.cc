@@ -0,0 +1,142 @@
+#include "shared_byte_ring.hh"
+#include "tcp_sponge_socket.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+static string random_string(const size_t len) {
+    auto rd = get_random_generator();
+    string ret(len, 0);
+    generate(ret.begin(), ret.end(), [&] { return rd(); });
+    return ret;
+}
+
+// an exception escaping a thread calls std::terminate, so keep it for the caller to rethrow after join()
+template <typename F>
+static thread checked_thread(exception_ptr &error, F &&body) {
+    return thread([&error, body = forward<F>(body)]() mutable {
+        try {
+            body();
+        } catch (...) {
+            error = current_exception();
+        }
+    });
+}
+
+static void rethrow_if(const exception_ptr &error) {
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+// one producer thread and one consumer thread hammer a small ring with odd-sized chunks
+static void ring_two_threads() {
+    const string data = random_string(4 << 20);
+    SharedByteRing ring{1000};
+
+    thread producer([&] {
+        auto rd = get_random_generator();
+        size_t sent = 0;
+        while (sent < data.size()) {
+            const size_t len = ring.write(string_view(data).substr(sent, 1 + rd() % 1500));
+            if (len == 0) {
+                this_thread::yield();
+            }
+            sent += len;
+        }
+        ring.end_input();
+    });
+
+    // throwing while the producer is still joinable would terminate, so only note a violation here
+    string received;
+    bool over_capacity = false;
+    while (not ring.eof()) {
+        const auto chunk = ring.peek();
+        over_capacity |= ring.buffer_size() > 1000;
+        if (chunk.empty()) {
+            this_thread::yield();
+        }
+        received.append(chunk);
+        ring.pop(chunk.size());
+    }
+    producer.join();
+
+    test_err_if(over_capacity, "the ring holds more than its capacity");
+    test_err_if(received != data, "bytes came out of the ring corrupted or out of order");
+}
+
+// TCP over UDP on the loopback interface, with both ends using the shared-ring data path
+static void sockets_over_loopback() {
+    const string c2s = random_string(1 << 20);
+    const string s2c = random_string(300000);
+
+    UDPSocket server_udp;
+    server_udp.bind({"127.0.0.1", 0});
+    const Address server_address = server_udp.local_address();
+
+    TCPOverUDPSpongeSocket server{TCPOverUDPSocketAdapter(move(server_udp))};
+    TCPOverUDPSpongeSocket client{TCPOverUDPSocketAdapter(UDPSocket{})};
+    server.enable_shared_ring();
+    client.enable_shared_ring();
+
+    auto read_all = [](TCPOverUDPSpongeSocket &sock) {
+        string ret;
+        while (not sock.ring_eof()) {
+            ret += sock.ring_read();
+        }
+        return ret;
+    };
+
+    // each end writes from one thread while reading from another, like a full-duplex socket
+    auto write_all = [](TCPOverUDPSpongeSocket &sock, const string &data, exception_ptr &error) {
+        return checked_thread(error, [&sock, &data] {
+            test_err_if(sock.ring_write(data) != data.size(), "ring_write() did not accept every byte");
+            sock.ring_end_input();
+        });
+    };
+
+    string server_received;
+    exception_ptr server_error, server_writer_error, client_writer_error;
+    thread server_thread = checked_thread(server_error, [&] {
+        FdAdapterConfig c_ad;
+        c_ad.source = server_address;
+        server.listen_and_accept({}, c_ad);
+        auto writer = write_all(server, s2c, server_writer_error);
+        server_received = read_all(server);
+        writer.join();
+        server.wait_until_closed();
+    });
+
+    FdAdapterConfig c_ad;
+    c_ad.destination = server_address;
+    client.connect({}, c_ad);
+    auto writer = write_all(client, c2s, client_writer_error);
+    const string client_received = read_all(client);
+    writer.join();
+    client.wait_until_closed();
+    server_thread.join();
+    rethrow_if(server_error);
+    rethrow_if(server_writer_error);
+    rethrow_if(client_writer_error);
+
+    test_err_if(server_received != c2s, "client-to-server bytes were corrupted");
+    test_err_if(client_received != s2c, "server-to-client bytes were corrupted");
+}
+
+int main() {
+    try {
+        ring_two_threads();
+        sockets_over_loopback();
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -392,6 +392,8 @@ struct SendSegment : public TCPAction {
     uint16_t win{0};
     size_t payload_size{0};
     std::string data{};
+    std::optional<uint8_t> window_scale{};
+    std::optional<TCPHeader::Timestamps> timestamps{};
 
     SendSegment() {}
 
@@ -404,6 +406,8 @@ struct SendSegment : public TCPAction {
         ackno = seg.header().ackno;
         win = seg.header().win;
         data = seg.payload();
+        window_scale = seg.header().window_scale;
+        timestamps = seg.header().timestamps;
     }
 
     SendSegment &with_ack(bool ack_) {
@@ -455,6 +459,16 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_window_scale(uint8_t window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
+    SendSegment &with_timestamps(uint32_t value, uint32_t echo) {
+        timestamps = {value, echo};
+        return *this;
+    }
+
     TCPSegment get_segment() const {
         TCPSegment data_seg;
         data_seg.payload() = std::string(data);
@@ -466,6 +480,8 @@ struct SendSegment : public TCPAction {
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.window_scale = window_scale;
+        data_hdr.timestamps = timestamps;
         return data_seg;
     }
 
@@ -564,4 +580,25 @@ struct Close : public TCPAction {
     void execute(TCPTestHarness &harness) const { harness._fsm.end_input_stream(); }
 };
 
+struct Flush : public TCPAction {
+    std::string description() const { return "flush"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.flush(); }
+};
+
+struct SetCork : public TCPAction {
+    bool cork;
+
+    SetCork(const bool cork_) : cork(cork_) {}
+    std::string description() const { return cork ? "cork" : "uncork"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.set_cork(cork); }
+};
+
+struct SetQuickAck : public TCPAction {
+    bool quickack;
+
+    SetQuickAck(const bool quickack_) : quickack(quickack_) {}
+    std::string description() const { return quickack ? "quick-ACK mode on" : "quick-ACK mode off"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.set_quickack(quickack); }
+};
+
 #endif  // SPONGE_LIBSPONGE_TCP_EXPECTATION_HH
@@ -0,0 +1,200 @@
+#include "parser.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//把header后面接上raw的选项(按4字节补齐)和payload,算好校验和之后解析
+static TCPSegment parse_with_options(const TCPHeader &base, string options, const string &payload = "") {
+    options.resize((options.size() + 3) / 4 * 4, '\0');
+    TCPHeader header = base;
+    header.cksum = 0;
+    string raw = header.serialize() + options + payload;
+    raw[12] = static_cast<char>((TCPHeader::LENGTH + options.size()) / 4 << 4);
+    InternetChecksum check;
+    check.add(raw);
+    const uint16_t cksum = check.value();
+    raw[16] = static_cast<char>(cksum >> 8);
+    raw[17] = static_cast<char>(cksum & 0xff);
+
+    TCPSegment seg;
+    if (const auto res = seg.parse(string(raw)); res != ParseResult::NoError) {
+        throw runtime_error("parse failed: " + as_string(res));
+    }
+    return seg;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        TCPHeader base;
+        base.sport = 1234;
+        base.dport = 4321;
+        base.seqno = WrappingInt32{static_cast<uint32_t>(rd())};
+        base.ackno = WrappingInt32{static_cast<uint32_t>(rd())};
+        base.ack = true;
+        base.win = 5000;
+
+        // SACK-permitted and SACK blocks survive serialize() and parse(), and grow the data offset
+        {
+            TCPSegment seg;
+            seg.header() = base;
+            seg.header().syn = true;
+            seg.header().sack_permitted = true;
+            for (uint32_t i = 0; i < TCPHeader::MAX_SACK_BLOCKS; ++i) {
+                seg.header().sack.emplace_back(base.ackno + 100 * i + 10, base.ackno + 100 * i + 20);
+            }
+            seg.payload() = string("hello");
+            if (seg.header().options_length() != 4 + 4 + 8 * TCPHeader::MAX_SACK_BLOCKS) {
+                throw runtime_error("wrong options length");
+            }
+
+            TCPSegment parsed;
+            if (const auto res = parsed.parse(seg.serialize().concatenate()); res != ParseResult::NoError) {
+                throw runtime_error("round trip failed: " + as_string(res));
+            }
+            if (parsed.header().doff != (TCPHeader::LENGTH + seg.header().options_length()) / 4) {
+                throw runtime_error("data offset does not cover the options");
+            }
+            if (not parsed.header().sack_permitted or parsed.header().sack != seg.header().sack) {
+                throw runtime_error("options did not survive a round trip");
+            }
+            if (parsed.payload().str() != "hello") {
+                throw runtime_error("payload was not found after the options");
+            }
+        }
+
+        // the window scale survives a round trip next to SACK-permitted
+        {
+            TCPSegment seg;
+            seg.header() = base;
+            seg.header().syn = true;
+            seg.header().sack_permitted = true;
+            seg.header().window_scale = 7;
+            TCPSegment parsed;
+            if (const auto res = parsed.parse(seg.serialize().concatenate()); res != ParseResult::NoError) {
+                throw runtime_error("round trip failed: " + as_string(res));
+            }
+            if (not parsed.header().sack_permitted or parsed.header().window_scale != 7) {
+                throw runtime_error("window scale did not survive a round trip");
+            }
+        }
+
+        // timestamps survive a round trip, and leave room for three SACK blocks
+        {
+            TCPSegment seg;
+            seg.header() = base;
+            seg.header().timestamps = {0xdeadbeef, 42};
+            for (uint32_t i = 0; i < 3; ++i) {
+                seg.header().sack.emplace_back(base.ackno + 100 * i + 10, base.ackno + 100 * i + 20);
+            }
+            if (seg.header().options_length() != TCPHeader::MAX_OPTIONS_LENGTH) {
+                throw runtime_error("wrong options length with timestamps");
+            }
+            TCPSegment parsed;
+            if (const auto res = parsed.parse(seg.serialize().concatenate()); res != ParseResult::NoError) {
+                throw runtime_error("round trip failed: " + as_string(res));
+            }
+            if (parsed.header().timestamps != seg.header().timestamps or parsed.header().sack != seg.header().sack) {
+                throw runtime_error("timestamps did not survive a round trip");
+            }
+        }
+
+        // more SACK blocks than fit are refused
+        {
+            TCPHeader header = base;
+            header.sack.resize(TCPHeader::MAX_SACK_BLOCKS + 1, {base.ackno + 1, base.ackno + 2});
+            bool threw = false;
+            try {
+                header.serialize();
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            if (not threw) {
+                throw runtime_error("too many SACK blocks were serialized");
+            }
+        }
+
+        // so are options that do not fit together
+        {
+            TCPHeader header = base;
+            header.sack_permitted = true;
+            header.window_scale = 0;
+            header.sack.resize(TCPHeader::MAX_SACK_BLOCKS, {base.ackno + 1, base.ackno + 2});
+            bool threw = false;
+            try {
+                header.serialize();
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            if (not threw) {
+                throw runtime_error("options longer than 40 bytes were serialized");
+            }
+        }
+
+        // unknown options and padding are skipped
+        {
+            const string options = string{1, 1} + string{8, 10} + string(8, 'T') + string{4, 2} + string{0};
+            const TCPSegment seg = parse_with_options(base, options, "data");
+            if (not seg.header().sack_permitted or not seg.header().sack.empty()) {
+                throw runtime_error("SACK-permitted was not found among other options");
+            }
+            if (seg.payload().str() != "data") {
+                throw runtime_error("wrong payload after unknown options");
+            }
+        }
+
+        // a malformed option stops option parsing, but not the segment
+        {
+            const string options = string{4, 2} + string{5, 1} + string(6, '\xff');
+            const TCPSegment seg = parse_with_options(base, options, "data");
+            if (not seg.header().sack_permitted or not seg.header().sack.empty()) {
+                throw runtime_error("a malformed option was not ignored");
+            }
+            if (seg.payload().str() != "data") {
+                throw runtime_error("wrong payload after a malformed option");
+            }
+        }
+
+        // a window scale of the wrong length is skipped
+        {
+            const string options = string{3, 4, 7, 0} + string{4, 2};
+            const TCPSegment seg = parse_with_options(base, options);
+            if (seg.header().window_scale.has_value() or not seg.header().sack_permitted) {
+                throw runtime_error("a window scale of the wrong length was accepted");
+            }
+        }
+
+        // timestamps of the wrong length are skipped
+        {
+            const string options = string{8, 6} + string(4, 'x') + string{4, 2};
+            const TCPSegment seg = parse_with_options(base, options);
+            if (seg.header().timestamps.has_value() or not seg.header().sack_permitted) {
+                throw runtime_error("timestamps of the wrong length were accepted");
+            }
+        }
+
+        // SACK blocks of the wrong length are skipped
+        {
+            const string options = string{5, 6} + string(4, 'x');
+            const TCPSegment seg = parse_with_options(base, options);
+            if (not seg.header().sack.empty()) {
+                throw runtime_error("a truncated SACK block was accepted");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}